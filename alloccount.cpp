@@ -0,0 +1,148 @@
+#include "alloccount.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+using namespace std;
+
+static atomic<bool> tracking{false};
+static atomic<uint64_t> allocCount{0};
+static atomic<uint64_t> allocBytes{0};
+
+void setAllocTracking(bool enabled) {
+    tracking.store(enabled, memory_order_relaxed);
+}
+
+AllocCounts allocCounts() {
+    AllocCounts counts;
+    counts.count = allocCount.load(memory_order_relaxed);
+    counts.bytes = allocBytes.load(memory_order_relaxed);
+    return counts;
+}
+
+static void count(size_t n) {
+    if (tracking.load(memory_order_relaxed)) {
+        allocCount.fetch_add(1, memory_order_relaxed);
+        allocBytes.fetch_add(n, memory_order_relaxed);
+    }
+}
+
+// Todas las formas terminan en estas cuatro funciones, de modo que cada
+// reserva se libera con la funcion que le corresponde.
+static void* allocate(size_t n) noexcept {
+    count(n);
+    return malloc(n == 0 ? 1 : n);
+}
+
+static void* allocateAligned(size_t n, align_val_t al) noexcept {
+    count(n);
+    size_t align = static_cast<size_t>(al);
+#ifdef _WIN32
+    return _aligned_malloc(n == 0 ? 1 : n, align);
+#else
+    // aligned_alloc pide un tamanio multiplo de la alineacion.
+    return aligned_alloc(align, (n + align - 1) / align * align);
+#endif
+}
+
+static void release(void* p) noexcept {
+    free(p);
+}
+
+static void releaseAligned(void* p) noexcept {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+static void* orThrow(void* p) {
+    if (!p) {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+void* operator new(size_t n) {
+    return orThrow(allocate(n));
+}
+
+void* operator new[](size_t n) {
+    return orThrow(allocate(n));
+}
+
+void* operator new(size_t n, const nothrow_t&) noexcept {
+    return allocate(n);
+}
+
+void* operator new[](size_t n, const nothrow_t&) noexcept {
+    return allocate(n);
+}
+
+void* operator new(size_t n, align_val_t al) {
+    return orThrow(allocateAligned(n, al));
+}
+
+void* operator new[](size_t n, align_val_t al) {
+    return orThrow(allocateAligned(n, al));
+}
+
+void* operator new(size_t n, align_val_t al, const nothrow_t&) noexcept {
+    return allocateAligned(n, al);
+}
+
+void* operator new[](size_t n, align_val_t al, const nothrow_t&) noexcept {
+    return allocateAligned(n, al);
+}
+
+void operator delete(void* p) noexcept {
+    release(p);
+}
+
+void operator delete[](void* p) noexcept {
+    release(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    release(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    release(p);
+}
+
+void operator delete(void* p, const nothrow_t&) noexcept {
+    release(p);
+}
+
+void operator delete[](void* p, const nothrow_t&) noexcept {
+    release(p);
+}
+
+void operator delete(void* p, align_val_t) noexcept {
+    releaseAligned(p);
+}
+
+void operator delete[](void* p, align_val_t) noexcept {
+    releaseAligned(p);
+}
+
+void operator delete(void* p, size_t, align_val_t) noexcept {
+    releaseAligned(p);
+}
+
+void operator delete[](void* p, size_t, align_val_t) noexcept {
+    releaseAligned(p);
+}
+
+void operator delete(void* p, align_val_t, const nothrow_t&) noexcept {
+    releaseAligned(p);
+}
+
+void operator delete[](void* p, align_val_t, const nothrow_t&) noexcept {
+    releaseAligned(p);
+}
@@ -0,0 +1,21 @@
+#ifndef REGEX_NFA_ALLOCCOUNT_HPP
+#define REGEX_NFA_ALLOCCOUNT_HPP
+
+#include <cstdint>
+
+// Conteo de reservas de memoria del proceso. alloccount.cpp reemplaza todas
+// las formas del operator new/delete global (escalar, arreglo, con tamanio,
+// alineadas y nothrow), asi que solo se compila en los ejecutables que miden
+// (RegexNFA y regex_nfa_bench), no en la biblioteca. Mientras el conteo este
+// apagado las reservas cuestan lo mismo que con el operador por defecto mas
+// una lectura atomica.
+struct AllocCounts {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+};
+
+void setAllocTracking(bool enabled);
+// Reservas contadas desde el inicio del proceso.
+AllocCounts allocCounts();
+
+#endif
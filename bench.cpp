@@ -0,0 +1,550 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <fstream>
+#include <cstdio>
+#include <random>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#include "nfa.hpp"
+#include "jsonwriter.hpp"
+#include "binfmt.hpp"
+#include "regexset.hpp"
+#include "pikevm.hpp"
+#include "lazydfa.hpp"
+#include "bitnfa.hpp"
+#include "prefilter.hpp"
+#include "regexgen.hpp"
+#include "profile.hpp"
+#include "alloccount.hpp"
+
+using namespace std;
+
+// Expresiones sinteticas con aproximadamente n operadores tras addConcat.
+static string concatChain(size_t n) {
+    string s;
+    for (size_t i = 0; i <= n; ++i) {
+        s.push_back("ab"[i % 2]);
+    }
+    return s;
+}
+
+static string unionChain(size_t n) {
+    string s = "a";
+    for (size_t i = 0; i < n; ++i) {
+        s += "+";
+        s.push_back("ab"[i % 2]);
+    }
+    return s;
+}
+
+static string nestedUnion(size_t n) {
+    string s;
+    for (size_t i = 0; i < n; ++i) {
+        s.push_back("ab"[i % 2]);
+        s += "+(";
+    }
+    s += "a";
+    s.append(n, ')');
+    return s;
+}
+
+static string nestedStar(size_t n) {
+    string s;
+    s.append(n / 2, '(');
+    s += "a";
+    for (size_t i = 0; i < n / 2; ++i) {
+        s += ")*";
+        s.push_back("ab"[i % 2]);
+    }
+    return s;
+}
+
+// Expresion aleatoria reproducible con n simbolos, de regexgen.
+static string randomRegex(size_t n) {
+    GeneratorOptions opts;
+    opts.length = n;
+    opts.maxDepth = 12;
+    return generateRegex(opts);
+}
+
+static double elapsedMs(chrono::steady_clock::time_point t0) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+// Pico de memoria residente en KiB. En Linux se lee VmHWM, que resetPeakRss()
+// reinicia para medir cada fase por separado; en otros sistemas se usa el pico
+// del proceso completo.
+static void resetPeakRss() {
+#ifdef __linux__
+    ofstream clear("/proc/self/clear_refs");
+    clear << "5";
+#endif
+}
+
+static long peakRssKb() {
+#ifdef __linux__
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return stol(line.substr(6));
+        }
+    }
+#endif
+#ifndef _WIN32
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#else
+    return 0;
+#endif
+}
+
+struct BenchOptions {
+    bool json = false;
+    bool quick = false;
+    bool graphviz = false;
+};
+
+struct PhaseResult {
+    string phase;
+    string shape;
+    size_t symbols;     // largo de la forma postfija
+    size_t states;
+    size_t reps;
+    double ns;          // por repeticion
+    uint64_t allocs;    // por repeticion
+    uint64_t bytes;
+    long peakRssKb;
+};
+
+// Corre body reps veces y mide tiempo, reservas y pico de memoria.
+template <typename F>
+static PhaseResult measure(const string& phase, size_t reps, F body) {
+    resetPeakRss();
+    AllocCounts before = allocCounts();
+    auto t0 = chrono::steady_clock::now();
+    for (size_t r = 0; r < reps; ++r) {
+        body();
+    }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+    PhaseResult res{};
+    res.phase = phase;
+    res.reps = reps;
+    res.ns = ns / reps;
+    AllocCounts after = allocCounts();
+    res.allocs = (after.count - before.count) / reps;
+    res.bytes = (after.bytes - before.bytes) / reps;
+    res.peakRssKb = peakRssKb();
+    return res;
+}
+
+static void printPhase(const PhaseResult& r, const BenchOptions& opts) {
+    if (opts.json) {
+        OutputSink sink(cout);
+        JsonWriter w(sink, 0);
+        w.beginObject();
+        w.key("suite");
+        w.value("phases");
+        w.key("phase");
+        w.value(r.phase);
+        w.key("shape");
+        w.value(r.shape);
+        w.key("symbols");
+        w.value(static_cast<uint64_t>(r.symbols));
+        w.key("states");
+        w.value(static_cast<uint64_t>(r.states));
+        w.key("reps");
+        w.value(static_cast<uint64_t>(r.reps));
+        w.key("ns");
+        w.value(r.ns);
+        w.key("ns_per_symbol");
+        w.value(r.ns / max<size_t>(1, r.symbols));
+        w.key("allocs");
+        w.value(r.allocs);
+        w.key("alloc_bytes");
+        w.value(r.bytes);
+        w.key("peak_rss_kb");
+        w.value(static_cast<int64_t>(r.peakRssKb));
+        w.endObject();
+        sink.put('\n');
+        return;
+    }
+    cout << left << setw(14) << r.phase << setw(14) << r.shape << right << setw(10) << r.symbols << setw(10)
+         << r.states << fixed << setprecision(3) << setw(12) << r.ns / 1e6 << setprecision(1) << setw(10)
+         << r.ns / max<size_t>(1, r.symbols) << setw(10) << r.allocs << setw(12) << r.bytes / 1024 << setw(10)
+         << r.peakRssKb / 1024 << endl;
+}
+
+// Cada fase de la herramienta por separado (addConcat, parseRegEx, thompson,
+// names, nfaJson y visualize_nfa) sobre expresiones sinteticas crecientes.
+// visualize_nfa solo escribe el DOT salvo con --graphviz, para no medir dot.
+static void benchPhases(const BenchOptions& opts) {
+    vector<pair<string, function<string(size_t)>>> shapes = {
+        {"concat", concatChain},
+        {"union", unionChain},
+        {"nested_union", nestedUnion},
+        {"nested_star", nestedStar},
+        {"random", randomRegex},
+    };
+    vector<size_t> sizes = {1000, 10000, 100000, 1000000};
+    if (opts.quick) {
+        sizes = {1000, 10000};
+    }
+    if (!opts.json) {
+        cout << left << setw(14) << "phase" << setw(14) << "shape" << right << setw(10) << "symbols" << setw(10)
+             << "states" << setw(12) << "ms" << setw(10) << "ns/sym" << setw(10) << "allocs" << setw(12)
+             << "alloc KiB" << setw(10) << "RSS MiB" << endl;
+    }
+    const string base = "bench_phase";
+    for (auto& shape : shapes) {
+        for (size_t n : sizes) {
+            string regEx = shape.second(n);
+            // Se repiten las entradas chicas para que cada medicion dure algo.
+            size_t reps = max<size_t>(1, 100000 / n);
+            string normalized;
+            vector<char> postfix;
+            NFA nfa;
+            auto arena = make_shared<StateArena>();
+            vector<PhaseResult> results;
+            results.push_back(measure("addConcat", reps, [&] {
+                normalized = addConcat(regEx);
+            }));
+            results.push_back(measure("parseRegEx", reps, [&] {
+                parseRegEx(normalized, postfix);
+            }));
+            results.push_back(measure("thompson", reps, [&] {
+                arena->reset();
+                nfa = thompson(postfix, arena);
+            }));
+            nfa.getAlph(regEx);
+            results.push_back(measure("names", reps, [&] {
+                nfa.names();
+            }));
+            results.push_back(measure("nfaJson", reps, [&] {
+                nfa.nfaJson(base + ".json");
+            }));
+            results.push_back(measure("visualize_nfa", opts.graphviz ? 1 : reps, [&] {
+                if (opts.graphviz) {
+                    visualize_nfa(nfa, base);
+                } else {
+                    ofstream dot(base + ".dot", ios::binary);
+                    OutputSink sink(dot);
+                    nfa.writeDot(sink);
+                }
+            }));
+            for (auto& r : results) {
+                r.shape = shape.first;
+                r.symbols = postfix.size();
+                r.states = nfa.flat.size();
+                printPhase(r, opts);
+            }
+        }
+    }
+    remove((base + ".json").c_str());
+    remove((base + ".dot").c_str());
+    remove((base + ".png").c_str());
+}
+
+// Salida de main(): nfaJson y DOT. Antes el DOT se armaba releyendo y
+// parseando el JSON escrito; ahora sale directo del automata en memoria.
+static void benchOutput() {
+    cout << endl << left << setw(14) << "output" << right << setw(10) << "states" << setw(12) << "json ms"
+         << setw(12) << "reparse ms" << setw(12) << "dot ms" << endl;
+    const string path = "bench_output.json";
+    for (size_t n : {10000, 100000, 300000}) {
+        NFA nfa = thompson(nestedUnion(n));
+        nfa.names();
+        auto t0 = chrono::steady_clock::now();
+        nfa.nfaJson(path);
+        double jsonMs = elapsedMs(t0);
+
+        t0 = chrono::steady_clock::now();
+        {
+            ifstream file(path);
+            nlohmann::json nfa_json;
+            file >> nfa_json;
+        }
+        double reparseMs = elapsedMs(t0);
+
+        t0 = chrono::steady_clock::now();
+        {
+            ofstream dot("bench_output.dot", ios::binary);
+            OutputSink sink(dot);
+            nfa.writeDot(sink);
+        }
+        double dotMs = elapsedMs(t0);
+        cout << left << setw(14) << "nested_union" << right << setw(10) << nfa.flat.size() << fixed << setprecision(2)
+             << setw(12) << jsonMs << setw(12) << reparseMs << setw(12) << dotMs << endl;
+    }
+    remove(path.c_str());
+    remove("bench_output.dot");
+}
+
+// Arranque de un servicio que carga el automata ya compilado: parsear el JSON
+// y rearmar la tabla, frente a mapear el formato binario (y copiarlo a un
+// FlatNFA, para los motores que lo necesitan).
+static FlatNFA loadJsonFlat(const string& path) {
+    ifstream file(path);
+    nlohmann::json j;
+    file >> j;
+    unordered_map<string, uint32_t> index;
+    for (auto& name : j["states"]) {
+        index.emplace(name.get<string>(), static_cast<uint32_t>(index.size()));
+    }
+    FlatNFA flat;
+    flat.offsets.assign(index.size() + 1, 0);
+    for (auto& t : j["transition_function"]) {
+        flat.offsets[index.at(t[0].get<string>()) + 1]++;
+    }
+    for (size_t i = 0; i < index.size(); ++i) {
+        flat.offsets[i + 1] += flat.offsets[i];
+    }
+    vector<uint32_t> pos(flat.offsets.begin(), flat.offsets.end() - 1);
+    flat.targets.resize(flat.offsets.back());
+    flat.labels.resize(flat.offsets.back());
+    for (auto& t : j["transition_function"]) {
+        uint32_t e = pos[index.at(t[0].get<string>())]++;
+        flat.targets[e] = index.at(t[2].get<string>());
+        flat.labels[e] = static_cast<unsigned char>(t[1].get<string>()[0]);
+    }
+    flat.start = index.at(j["start_states"][0].get<string>());
+    for (auto& name : j["final_states"]) {
+        flat.accept.push_back(index.at(name.get<string>()));
+    }
+    return flat;
+}
+
+static void benchLoad() {
+    cout << endl << left << setw(14) << "load" << right << setw(10) << "states" << setw(12) << "json ms"
+         << setw(12) << "mmap ms" << setw(12) << "flat ms" << setw(12) << "json KiB" << setw(12) << "bin KiB" << endl;
+    const string jsonPath = "bench_load.json";
+    const string binPath = "bench_load.bin";
+    for (size_t n : {10000, 100000, 300000}) {
+        NFA nfa = thompson(nestedUnion(n));
+        nfa.names();
+        nfa.nfaJson(jsonPath);
+        saveBinary(binPath, nfa);
+
+        auto t0 = chrono::steady_clock::now();
+        FlatNFA fromJson = loadJsonFlat(jsonPath);
+        double jsonMs = elapsedMs(t0);
+
+        t0 = chrono::steady_clock::now();
+        size_t edges;
+        {
+            MappedAutomaton mapped(binPath);
+            edges = mapped.nfa().numEdges;
+        }
+        double mmapMs = elapsedMs(t0);
+
+        t0 = chrono::steady_clock::now();
+        FlatNFA fromBin = MappedAutomaton(binPath).nfa().toFlat();
+        double flatMs = elapsedMs(t0);
+
+        if (fromBin.targets.size() != edges || fromJson.targets.size() != edges) {
+            cerr << "load mismatch" << endl;
+        }
+        ifstream jsonFile(jsonPath, ios::binary | ios::ate);
+        ifstream binFile(binPath, ios::binary | ios::ate);
+        cout << left << setw(14) << "nested_union" << right << setw(10) << nfa.flat.size() << fixed << setprecision(2)
+             << setw(12) << jsonMs << setw(12) << mmapMs << setw(12) << flatMs << setw(12)
+             << static_cast<size_t>(jsonFile.tellg()) / 1024 << setw(12) << static_cast<size_t>(binFile.tellg()) / 1024
+             << endl;
+    }
+    remove(jsonPath.c_str());
+    remove(binPath.c_str());
+}
+
+// Lineas de log contra muchos patrones: un RegexSet en una sola pasada frente
+// a buscar con un PikeVM por patron.
+static void benchSet() {
+    cout << endl << left << setw(14) << "set" << right << setw(10) << "patterns" << setw(12) << "loop ms"
+         << setw(12) << "set ms" << setw(12) << "speedup" << endl;
+    mt19937 rng(42);
+    auto word = [&](size_t len) {
+        string w;
+        for (size_t i = 0; i < len; ++i) {
+            w.push_back("abcdefghijklmnopqrstuvwxyz"[rng() % 26]);
+        }
+        return w;
+    };
+    vector<string> lines;
+    for (size_t i = 0; i < 2000; ++i) {
+        lines.push_back(word(120));
+    }
+    for (size_t count : {10, 100, 300}) {
+        vector<string> patterns;
+        for (size_t k = 0; k < count; ++k) {
+            patterns.push_back(word(2) + "(" + word(1) + "+" + word(1) + ")*" + word(1) + "(0+1+" + word(1) + ")");
+        }
+        vector<PikeVM> vms;
+        for (auto& p : patterns) {
+            vms.emplace_back(thompson(p).flat);
+        }
+        RegexSet set(patterns);
+
+        auto t0 = chrono::steady_clock::now();
+        size_t loopHits = 0;
+        for (auto& line : lines) {
+            for (auto& vm : vms) {
+                loopHits += vm.search(line);
+            }
+        }
+        double loopMs = elapsedMs(t0);
+
+        t0 = chrono::steady_clock::now();
+        size_t setHits = 0;
+        for (auto& line : lines) {
+            setHits += set.search(line).size();
+        }
+        double setMs = elapsedMs(t0);
+        if (loopHits != setHits) {
+            cerr << "set mismatch: " << loopHits << " != " << setHits << endl;
+        }
+        cout << left << setw(14) << "log_lines" << right << setw(10) << count << fixed << setprecision(2)
+             << setw(12) << loopMs << setw(12) << setMs << setw(12) << loopMs / setMs << endl;
+    }
+}
+
+// Entrada sin coincidencias: el prefiltro la descarta con memchr en lugar de
+// simular el automata byte a byte.
+static void benchPrefilter() {
+    cout << endl << left << setw(22) << "prefilter" << right << setw(10) << "literal" << setw(12) << "pike ms"
+         << setw(12) << "filter ms" << setw(12) << "MB/s" << endl;
+    mt19937 rng(7);
+    string text(4 << 20, ' ');
+    for (auto& c : text) {
+        c = "abcdfghijklmnpqstuvwxyz"[rng() % 23];
+    }
+    for (string regEx : {"error.(a+b)*", "(x+y)*warning", "fail(0+1)*ed", "(0+1)(0+1)*"}) {
+        PikeVM vm(thompson(regEx).flat);
+        PrefilteredSearch filtered(regEx);
+        auto t0 = chrono::steady_clock::now();
+        bool a = vm.search(text);
+        double pikeMs = elapsedMs(t0);
+        t0 = chrono::steady_clock::now();
+        bool b = filtered.search(text);
+        double filterMs = elapsedMs(t0);
+        if (a != b) {
+            cerr << "prefilter mismatch: " << regEx << endl;
+        }
+        cout << left << setw(22) << regEx << right << setw(10) << filtered.literals().required << fixed
+             << setprecision(2) << setw(12) << pikeMs << setw(12) << filterMs << setw(12)
+             << text.size() / 1e3 / filterMs << endl;
+    }
+}
+
+// Contadores de hardware por fase (ciclos, instrucciones, fallos de cache y de
+// prediccion de saltos) para construccion, nombres, serializacion y cada motor
+// de busqueda. La tabla va a stderr; sin contadores disponibles solo se avisa.
+static void benchCounters() {
+    PerfCounters& counters = PerfCounters::forThread();
+    if (!counters.available()) {
+        cerr << "Hardware counters unavailable: " << counters.error() << endl;
+        return;
+    }
+    Profile profile(false, true);
+    string regEx = randomRegex(100000);
+    NFA nfa;
+    {
+        PhaseScope phase(&profile, "thompson");
+        nfa = thompson(regEx);
+    }
+    {
+        PhaseScope phase(&profile, "names");
+        nfa.names();
+    }
+    {
+        PhaseScope phase(&profile, "nfaJson");
+        ofstream sinkFile("bench_counters.json", ios::binary);
+        OutputSink sink(sinkFile);
+        nfa.writeJson(sink, false);
+    }
+    remove("bench_counters.json");
+
+    mt19937 rng(3);
+    string text(1 << 20, ' ');
+    for (auto& c : text) {
+        c = "abcdefghijklmnopqrstuvwxyz"[rng() % 26];
+    }
+    // Una sola coincidencia al final: cada motor recorre todo el texto.
+    text.replace(text.size() - 8, 4, "abcd");
+    FlatNFA flat = thompson("(a+b)*abc(d+e)(a+b+c)*").flat;
+    bool found = false;
+    {
+        PikeVM vm(flat);
+        PhaseScope phase(&profile, "pikevm");
+        found |= vm.search(text);
+    }
+    {
+        LazyDFA dfa(flat);
+        PhaseScope phase(&profile, "lazydfa");
+        found |= dfa.search(text);
+    }
+    {
+        BitParallelNFA bits(flat);
+        PhaseScope phase(&profile, "bitnfa");
+        found |= bits.search(text);
+    }
+    {
+        PrefilteredSearch filtered("(a+b)*abc(d+e)(a+b+c)*");
+        PhaseScope phase(&profile, "prefilter");
+        found |= filtered.search(text);
+    }
+    if (!found) {
+        cerr << "counters: no match in sample text" << endl;
+    }
+    profile.writeCounters(cerr, counters);
+}
+
+int main(int argc, char* argv[]) {
+    setAllocTracking(true);
+    BenchOptions opts;
+    vector<string> suites;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--json") {
+            opts.json = true;
+        } else if (arg == "--quick") {
+            opts.quick = true;
+        } else if (arg == "--graphviz") {
+            opts.graphviz = true;
+        } else if (arg == "phases" || arg == "output" || arg == "load" || arg == "set" || arg == "prefilter" ||
+                   arg == "counters") {
+            suites.push_back(arg);
+        } else {
+            cerr << "Usage: regex_nfa_bench [--json] [--quick] [--graphviz] [phases|output|load|set|prefilter|counters]..."
+                 << endl;
+            return 1;
+        }
+    }
+    // Con --json solo se emite la suite de fases, una medicion por linea.
+    if (suites.empty()) {
+        suites = opts.json ? vector<string>{"phases"} : vector<string>{"phases", "output", "load", "set", "prefilter"};
+    }
+    for (auto& suite : suites) {
+        if (suite == "phases") {
+            benchPhases(opts);
+        } else if (opts.json) {
+            cerr << "--json only applies to the phases suite" << endl;
+            return 1;
+        } else if (suite == "output") {
+            benchOutput();
+        } else if (suite == "load") {
+            benchLoad();
+        } else if (suite == "set") {
+            benchSet();
+        } else if (suite == "counters") {
+            benchCounters();
+        } else {
+            benchPrefilter();
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,287 @@
+#include "binfmt.hpp"
+#include "jsonwriter.hpp"
+#include <fstream>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+static size_t align8(size_t x) {
+    return (x + 7) & ~size_t(7);
+}
+
+// Bytes que ocupa cada seccion segun los contadores de la cabecera.
+static size_t sectionBytes(const BinaryHeader& h, int section) {
+    switch (section) {
+    case BIN_OFFSETS:
+        return h.numStates == 0 ? 0 : (size_t(h.numStates) + 1) * sizeof(uint32_t);
+    case BIN_TARGETS:
+        return size_t(h.numEdges) * sizeof(uint32_t);
+    case BIN_LABELS:
+        return h.numEdges;
+    case BIN_ACCEPT:
+        return size_t(h.numAccept) * sizeof(uint32_t);
+    case BIN_ALPHABET:
+        return h.alphabetSize;
+    case BIN_NAMES:
+        return size_t(h.numStates) * sizeof(uint32_t);
+    case BIN_DFA_CLASS_OF:
+        return h.dfaStates == 0 ? 0 : 256 * sizeof(uint16_t);
+    case BIN_DFA_SYMBOLS:
+        return h.dfaClasses == 0 ? 0 : h.dfaClasses - 1;
+    case BIN_DFA_TABLE:
+        return size_t(h.dfaStates) * h.dfaClasses * sizeof(int32_t);
+    case BIN_DFA_ACCEPT:
+        return h.dfaStates;
+    }
+    return 0;
+}
+
+void writeBinary(OutputSink& sink, const NFA& nfa, const DFA* dfa) {
+    const FlatNFA& flat = nfa.flat;
+    BinaryHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, BINARY_MAGIC, sizeof(h.magic));
+    h.version = BINARY_VERSION;
+    h.byteOrder = BINARY_BYTE_ORDER;
+    h.numStates = static_cast<uint32_t>(flat.size());
+    h.numEdges = static_cast<uint32_t>(flat.targets.size());
+    h.start = flat.start;
+    h.numAccept = static_cast<uint32_t>(flat.accept.size());
+    h.alphabetSize = static_cast<uint32_t>(nfa.alphabet.size());
+    if (dfa && dfa->size() > 0) {
+        h.dfaStates = static_cast<uint32_t>(dfa->size());
+        h.dfaClasses = static_cast<uint32_t>(dfa->numClasses);
+        h.dfaStart = dfa->start;
+    }
+    size_t pos = align8(sizeof(BinaryHeader));
+    for (int s = 0; s < BIN_SECTIONS; ++s) {
+        h.section[s] = pos;
+        pos = align8(pos + sectionBytes(h, s));
+    }
+    h.fileSize = pos;
+
+    size_t written = 0;
+    auto emit = [&](const void* p, size_t bytes) {
+        sink.write(string_view(static_cast<const char*>(p), bytes));
+        written += bytes;
+    };
+    auto pad = [&]() {
+        while (written % 8 != 0) {
+            sink.put('\0');
+            written++;
+        }
+    };
+    emit(&h, sizeof(h));
+    pad();
+    emit(flat.offsets.data(), sectionBytes(h, BIN_OFFSETS));
+    pad();
+    emit(flat.targets.data(), sectionBytes(h, BIN_TARGETS));
+    pad();
+    emit(flat.labels.data(), sectionBytes(h, BIN_LABELS));
+    pad();
+    emit(flat.accept.data(), sectionBytes(h, BIN_ACCEPT));
+    pad();
+    for (char c : nfa.alphabet) {
+        emit(&c, 1);
+    }
+    pad();
+    if (nfa.nameIds.size() == flat.size()) {
+        emit(nfa.nameIds.data(), sectionBytes(h, BIN_NAMES));
+    } else {
+        for (size_t i = 0; i < flat.size(); ++i) {
+            emit(&NFA::UNNAMED, sizeof(uint32_t));
+        }
+    }
+    pad();
+    if (h.dfaStates != 0) {
+        emit(dfa->classOf.data(), sectionBytes(h, BIN_DFA_CLASS_OF));
+        pad();
+        emit(dfa->classSymbols.data(), sectionBytes(h, BIN_DFA_SYMBOLS));
+        pad();
+        emit(dfa->table.data(), sectionBytes(h, BIN_DFA_TABLE));
+        pad();
+        emit(dfa->accept.data(), sectionBytes(h, BIN_DFA_ACCEPT));
+        pad();
+    }
+}
+
+void saveBinary(const string& path, const NFA& nfa, const DFA* dfa) {
+    ofstream file(path, ios::binary);
+    if (!file) {
+        throw runtime_error("Cannot open " + path);
+    }
+    OutputSink sink(file);
+    writeBinary(sink, nfa, dfa);
+}
+
+FlatNFA NFAView::toFlat() const {
+    FlatNFA flat;
+    if (numStates == 0) {
+        return flat;
+    }
+    flat.offsets.assign(offsets, offsets + numStates + 1);
+    flat.targets.assign(targets, targets + numEdges);
+    flat.labels.assign(labels, labels + numEdges);
+    flat.start = start;
+    flat.accept.assign(accept, accept + numAccept);
+    return flat;
+}
+
+bool DFAView::match(string_view input) const {
+    if (numStates == 0) {
+        return false;
+    }
+    int32_t s = start;
+    for (char ch : input) {
+        s = next(s, static_cast<unsigned char>(ch));
+        if (s < 0) {
+            return false;
+        }
+    }
+    return accept[s] != 0;
+}
+
+MappedAutomaton::MappedAutomaton(const string& path) {
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("Cannot open " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw runtime_error("Cannot open " + path);
+    }
+    length = static_cast<size_t>(st.st_size);
+    if (length > 0) {
+        void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            throw runtime_error("Cannot map " + path);
+        }
+        data = static_cast<const unsigned char*>(p);
+    }
+    close(fd);
+#else
+    ifstream file(path, ios::binary | ios::ate);
+    if (!file) {
+        throw runtime_error("Cannot open " + path);
+    }
+    length = static_cast<size_t>(file.tellg());
+    buffer.resize((length + 7) / 8);
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer.data()), static_cast<streamsize>(length));
+    data = reinterpret_cast<const unsigned char*>(buffer.data());
+#endif
+    try {
+        bind();
+    } catch (...) {
+        unmap();
+        throw;
+    }
+}
+
+MappedAutomaton::MappedAutomaton(MappedAutomaton&& other) noexcept
+    : data(other.data), length(other.length), buffer(move(other.buffer)),
+      nfaView(other.nfaView), dfaView(other.dfaView) {
+    other.data = nullptr;
+    other.length = 0;
+}
+
+MappedAutomaton& MappedAutomaton::operator=(MappedAutomaton&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        data = other.data;
+        length = other.length;
+        buffer = move(other.buffer);
+        nfaView = other.nfaView;
+        dfaView = other.dfaView;
+        other.data = nullptr;
+        other.length = 0;
+    }
+    return *this;
+}
+
+MappedAutomaton::~MappedAutomaton() {
+    unmap();
+}
+
+void MappedAutomaton::unmap() {
+#ifndef _WIN32
+    if (data && length > 0) {
+        munmap(const_cast<unsigned char*>(data), length);
+    }
+#endif
+    buffer.clear();
+    data = nullptr;
+    length = 0;
+}
+
+const DFAView& MappedAutomaton::dfa() const {
+    if (!hasDFA()) {
+        throw logic_error("Binary automaton has no DFA section");
+    }
+    return dfaView;
+}
+
+// Valida la cabecera y apunta las vistas a las secciones; no recorre las tablas.
+void MappedAutomaton::bind() {
+    if (length < sizeof(BinaryHeader)) {
+        throw runtime_error("Invalid binary automaton: truncated header");
+    }
+    const BinaryHeader& h = header();
+    if (memcmp(h.magic, BINARY_MAGIC, sizeof(h.magic)) != 0) {
+        throw runtime_error("Invalid binary automaton: bad magic");
+    }
+    if (h.version != BINARY_VERSION) {
+        throw runtime_error("Unsupported binary automaton version " + to_string(h.version));
+    }
+    if (h.byteOrder != BINARY_BYTE_ORDER) {
+        throw runtime_error("Invalid binary automaton: written with a different byte order");
+    }
+    if (h.fileSize != length) {
+        throw runtime_error("Invalid binary automaton: size mismatch");
+    }
+    for (int s = 0; s < BIN_SECTIONS; ++s) {
+        if (h.section[s] % 8 != 0 || h.section[s] > length || sectionBytes(h, s) > length - h.section[s]) {
+            throw runtime_error("Invalid binary automaton: section out of range");
+        }
+    }
+    if ((h.numStates > 0 && h.start >= h.numStates) || (h.dfaStates > 0 && uint32_t(h.dfaStart) >= h.dfaStates)) {
+        throw runtime_error("Invalid binary automaton: start state out of range");
+    }
+    auto at = [&](int s) {
+        return data + h.section[s];
+    };
+
+    nfaView.numStates = h.numStates;
+    nfaView.numEdges = h.numEdges;
+    nfaView.start = h.start;
+    nfaView.numAccept = h.numAccept;
+    nfaView.alphabetSize = h.alphabetSize;
+    nfaView.offsets = reinterpret_cast<const uint32_t*>(at(BIN_OFFSETS));
+    nfaView.targets = reinterpret_cast<const uint32_t*>(at(BIN_TARGETS));
+    nfaView.labels = at(BIN_LABELS);
+    nfaView.accept = reinterpret_cast<const uint32_t*>(at(BIN_ACCEPT));
+    nfaView.alphabet = at(BIN_ALPHABET);
+    nfaView.nameIds = reinterpret_cast<const uint32_t*>(at(BIN_NAMES));
+    if (h.numStates > 0 && nfaView.offsets[h.numStates] != h.numEdges) {
+        throw runtime_error("Invalid binary automaton: edge count mismatch");
+    }
+
+    dfaView.numStates = h.dfaStates;
+    dfaView.numClasses = h.dfaClasses;
+    dfaView.start = h.dfaStart;
+    dfaView.classOf = reinterpret_cast<const uint16_t*>(at(BIN_DFA_CLASS_OF));
+    dfaView.classSymbols = at(BIN_DFA_SYMBOLS);
+    dfaView.table = reinterpret_cast<const int32_t*>(at(BIN_DFA_TABLE));
+    dfaView.accept = at(BIN_DFA_ACCEPT);
+}
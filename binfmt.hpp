@@ -0,0 +1,135 @@
+#ifndef REGEX_NFA_BINFMT_HPP
+#define REGEX_NFA_BINFMT_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "nfa.hpp"
+#include "dfa.hpp"
+
+// Formato binario del automata compilado, pensado para mapearse en memoria y
+// usarse sin deserializar. Tras la cabecera fija vienen las secciones, cada
+// una alineada a 8 bytes y en el orden nativo de la maquina que la escribio;
+// section[] guarda el desplazamiento de cada una desde el inicio del archivo.
+enum BinarySection {
+    BIN_OFFSETS,        // uint32[numStates + 1], tabla CSR
+    BIN_TARGETS,        // uint32[numEdges]
+    BIN_LABELS,         // uint8[numEdges]
+    BIN_ACCEPT,         // uint32[numAccept]
+    BIN_ALPHABET,       // uint8[alphabetSize]
+    BIN_NAMES,          // uint32[numStates], numero de names() o UINT32_MAX
+    BIN_DFA_CLASS_OF,   // uint16[256]
+    BIN_DFA_SYMBOLS,    // uint8[dfaClasses - 1]
+    BIN_DFA_TABLE,      // int32[dfaStates * dfaClasses]
+    BIN_DFA_ACCEPT,     // uint8[dfaStates]
+    BIN_SECTIONS
+};
+
+struct BinaryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t numStates;
+    uint32_t numEdges;
+    uint32_t start;
+    uint32_t numAccept;
+    uint32_t alphabetSize;
+    uint32_t dfaStates;     // 0 si el archivo no incluye DFA
+    uint32_t dfaClasses;
+    int32_t dfaStart;
+    uint64_t fileSize;
+    uint64_t section[BIN_SECTIONS];
+};
+
+constexpr char BINARY_MAGIC[8] = {'R', 'E', 'G', 'E', 'X', 'N', 'F', 'A'};
+constexpr uint32_t BINARY_VERSION = 1;
+constexpr uint32_t BINARY_BYTE_ORDER = 0x01020304;
+
+// Vista de solo lectura sobre las secciones del NFA; los punteros apuntan al
+// archivo mapeado y son validos mientras viva el MappedAutomaton.
+struct NFAView {
+    uint32_t numStates = 0;
+    uint32_t numEdges = 0;
+    uint32_t start = 0;
+    uint32_t numAccept = 0;
+    uint32_t alphabetSize = 0;
+    const uint32_t* offsets = nullptr;
+    const uint32_t* targets = nullptr;
+    const unsigned char* labels = nullptr;
+    const uint32_t* accept = nullptr;
+    const unsigned char* alphabet = nullptr;
+    const uint32_t* nameIds = nullptr;
+
+    size_t size() const {
+        return numStates;
+    }
+
+    // Copia la tabla para los motores que trabajan sobre FlatNFA.
+    FlatNFA toFlat() const;
+};
+
+struct DFAView {
+    uint32_t numStates = 0;
+    uint32_t numClasses = 0;
+    int32_t start = 0;
+    const uint16_t* classOf = nullptr;
+    const unsigned char* classSymbols = nullptr;
+    const int32_t* table = nullptr;
+    const unsigned char* accept = nullptr;
+
+    size_t size() const {
+        return numStates;
+    }
+
+    int32_t next(int32_t s, unsigned char c) const {
+        return table[s * numClasses + classOf[c]];
+    }
+
+    bool match(std::string_view input) const;
+};
+
+// Escribe el NFA (que debe estar finalizado; si names() no se llamo, los
+// estados quedan sin nombre) y, si se pasa, el DFA equivalente.
+void writeBinary(OutputSink& sink, const NFA& nfa, const DFA* dfa = nullptr);
+void saveBinary(const std::string& path, const NFA& nfa, const DFA* dfa = nullptr);
+
+// Abre un archivo escrito por saveBinary. En POSIX se mapea con mmap; en otras
+// plataformas se lee completo a memoria. Se comprueban la cabecera y que las
+// secciones caben en el archivo, pero no el contenido de las tablas.
+class MappedAutomaton {
+public:
+    explicit MappedAutomaton(const std::string& path);
+    MappedAutomaton(MappedAutomaton&& other) noexcept;
+    MappedAutomaton& operator=(MappedAutomaton&& other) noexcept;
+    MappedAutomaton(const MappedAutomaton&) = delete;
+    MappedAutomaton& operator=(const MappedAutomaton&) = delete;
+    ~MappedAutomaton();
+
+    const BinaryHeader& header() const {
+        return *reinterpret_cast<const BinaryHeader*>(data);
+    }
+
+    bool hasDFA() const {
+        return header().dfaStates != 0;
+    }
+
+    const NFAView& nfa() const {
+        return nfaView;
+    }
+
+    // Lanza logic_error si el archivo no incluye DFA.
+    const DFAView& dfa() const;
+
+private:
+    const unsigned char* data = nullptr;
+    size_t length = 0;
+    std::vector<uint64_t> buffer;   // solo sin mmap
+    NFAView nfaView;
+    DFAView dfaView;
+
+    void unmap();
+    void bind();
+};
+
+#endif
@@ -0,0 +1,157 @@
+#include "bitnfa.hpp"
+#include "epsilon.hpp"
+#include <stdexcept>
+#include <algorithm>
+
+using namespace std;
+
+BitParallelNFA::BitParallelNFA(const FlatNFA& flat)
+    : n(flat.size()), W(max<size_t>(1, (flat.size() + 63) / 64)), charMasks(256 * W, 0),
+      acceptMask(W, 0), startClosure(W, 0), entryIndex(flat.size(), UINT32_MAX), cur(W), next(W) {
+    if (n == 0) {
+        return;
+    }
+    vector<uint32_t> entries = {flat.start};
+    for (uint32_t s = 0; s < n; ++s) {
+        for (uint32_t e = flat.offsets[s]; e < flat.offsets[s + 1]; ++e) {
+            unsigned char c = flat.labels[e];
+            if (c == '$') {
+                continue;
+            }
+            if (flat.targets[e] != s + 1) {
+                throw invalid_argument("BitParallelNFA requires the state layout produced by thompson()");
+            }
+            charMasks[c * W + s / 64] |= uint64_t(1) << (s % 64);
+            entries.push_back(s + 1);
+        }
+    }
+    for (auto s : flat.accept) {
+        acceptMask[s / 64] |= uint64_t(1) << (s % 64);
+    }
+    EpsilonClosure closure(flat);
+    startClosure.assign(closure.row(flat.start), closure.row(flat.start) + W);
+
+    if (W == 1) {
+        closureTable.assign(8 * 256, 0);
+        for (size_t k = 0; k < 8; ++k) {
+            for (size_t b = 1; b < 256; ++b) {
+                size_t s = k * 8 + __builtin_ctz(static_cast<unsigned>(b));
+                uint64_t row = s < n ? closure.row(static_cast<uint32_t>(s))[0] : 0;
+                closureTable[k * 256 + b] = closureTable[k * 256 + (b & (b - 1))] | row;
+            }
+        }
+        return;
+    }
+
+    for (auto s : entries) {
+        if (entryIndex[s] != UINT32_MAX) {
+            continue;
+        }
+        entryIndex[s] = static_cast<uint32_t>(closureRows.size() / W);
+        closureRows.insert(closureRows.end(), closure.row(s), closure.row(s) + W);
+    }
+}
+
+void BitParallelNFA::closureN(const uint64_t* in, uint64_t* out) const {
+    fill(out, out + W, 0);
+    for (size_t w = 0; w < W; ++w) {
+        for (uint64_t x = in[w]; x != 0; x &= x - 1) {
+            size_t s = w * 64 + __builtin_ctzll(x);
+            const uint64_t* row = &closureRows[entryIndex[s] * W];
+            for (size_t i = 0; i < W; ++i) {
+                out[i] |= row[i];
+            }
+        }
+    }
+}
+
+bool BitParallelNFA::stepN(unsigned char c, bool restart) {
+    const uint64_t* mask = &charMasks[c * W];
+    uint64_t carry = 0;
+    for (size_t w = 0; w < W; ++w) {
+        uint64_t x = cur[w] & mask[w];
+        next[w] = (x << 1) | carry;
+        carry = x >> 63;
+    }
+    closureN(next.data(), cur.data());
+    bool any = false;
+    for (size_t w = 0; w < W; ++w) {
+        if (restart) {
+            cur[w] |= startClosure[w];
+        }
+        any |= cur[w] != 0;
+    }
+    return any;
+}
+
+bool BitParallelNFA::acceptsN() const {
+    for (size_t w = 0; w < W; ++w) {
+        if (cur[w] & acceptMask[w]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BitParallelNFA::match1(string_view input) const {
+    uint64_t d = startClosure[0];
+    for (char ch : input) {
+        d = closure1((d & charMasks[static_cast<unsigned char>(ch)]) << 1);
+        if (d == 0) {
+            return false;
+        }
+    }
+    return (d & acceptMask[0]) != 0;
+}
+
+bool BitParallelNFA::search1(string_view input) const {
+    uint64_t start = startClosure[0];
+    uint64_t accept = acceptMask[0];
+    uint64_t d = start;
+    if (d & accept) {
+        return true;
+    }
+    for (char ch : input) {
+        d = closure1((d & charMasks[static_cast<unsigned char>(ch)]) << 1) | start;
+        if (d & accept) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BitParallelNFA::match(string_view input) {
+    if (n == 0) {
+        return false;
+    }
+    if (W == 1) {
+        return match1(input);
+    }
+    cur = startClosure;
+    for (char ch : input) {
+        if (!stepN(static_cast<unsigned char>(ch), false)) {
+            return false;
+        }
+    }
+    return acceptsN();
+}
+
+bool BitParallelNFA::search(string_view input) {
+    if (n == 0) {
+        return false;
+    }
+    if (W == 1) {
+        return search1(input);
+    }
+    cur = startClosure;
+    if (acceptsN()) {
+        return true;
+    }
+    for (char ch : input) {
+        stepN(static_cast<unsigned char>(ch), true);
+        if (acceptsN()) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,52 @@
+#ifndef REGEX_NFA_BITNFA_HPP
+#define REGEX_NFA_BITNFA_HPP
+
+#include <vector>
+#include <string_view>
+#include <cstdint>
+#include "nfa.hpp"
+
+// Simulador bit-paralelo (estilo Shift-And) para la tabla plana que produce
+// thompson(). Alli cada arista con simbolo va del estado i al i + 1, asi que
+// un paso es: activos = clausura((activos & mascara[c]) << 1).
+// Con hasta 64 estados el conjunto activo cabe en un uint64_t y la clausura
+// epsilon se resuelve con 8 tablas de 256 mascaras (una por byte del
+// conjunto); con mas estados se usa un bitset de varias palabras.
+class BitParallelNFA {
+public:
+    explicit BitParallelNFA(const FlatNFA& flat);
+
+    bool match(std::string_view input);
+    // Indica si alguna subcadena de la entrada pertenece al lenguaje.
+    bool search(std::string_view input);
+
+    size_t words() const {
+        return W;
+    }
+
+private:
+    size_t n, W;
+    std::vector<uint64_t> charMasks;     // 256 * W: estados con arista etiquetada con el byte
+    std::vector<uint64_t> acceptMask;    // W
+    std::vector<uint64_t> startClosure;  // W
+    std::vector<uint64_t> closureTable;  // 8 * 256, solo si W == 1
+    std::vector<uint32_t> entryIndex;    // estado -> fila en closureRows
+    std::vector<uint64_t> closureRows;   // filas de W palabras, solo si W > 1
+    std::vector<uint64_t> cur, next;
+
+    uint64_t closure1(uint64_t x) const {
+        uint64_t r = 0;
+        for (size_t k = 0; x != 0; ++k, x >>= 8) {
+            r |= closureTable[k * 256 + (x & 255)];
+        }
+        return r;
+    }
+
+    void closureN(const uint64_t* in, uint64_t* out) const;
+    bool stepN(unsigned char c, bool restart);
+    bool acceptsN() const;
+    bool match1(std::string_view input) const;
+    bool search1(std::string_view input) const;
+};
+
+#endif
@@ -0,0 +1,39 @@
+#include "byteclasses.hpp"
+#include <map>
+#include <utility>
+#include <algorithm>
+
+using namespace std;
+
+ByteClasses::ByteClasses() : classOf(256, 0) {}
+
+ByteClasses::ByteClasses(const FlatNFA& flat) : classOf(256, 0) {
+    // Firma de cada byte: las aristas (origen, destino) que etiqueta.
+    vector<vector<pair<uint32_t, uint32_t>>> signature(256);
+    for (uint32_t s = 0; s < flat.size(); ++s) {
+        for (uint32_t e = flat.offsets[s]; e < flat.offsets[s + 1]; ++e) {
+            if (flat.labels[e] != '$') {
+                signature[flat.labels[e]].push_back({s, flat.targets[e]});
+            }
+        }
+    }
+    map<vector<pair<uint32_t, uint32_t>>, uint16_t> ids;
+    vector<int> unusedBytes;
+    for (int c = 0; c < 256; ++c) {
+        auto& sig = signature[c];
+        if (sig.empty()) {
+            unusedBytes.push_back(c);
+            continue;
+        }
+        sort(sig.begin(), sig.end());
+        auto it = ids.find(sig);
+        if (it == ids.end()) {
+            it = ids.emplace(move(sig), static_cast<uint16_t>(reps.size())).first;
+            reps.push_back(static_cast<unsigned char>(c));
+        }
+        classOf[c] = it->second;
+    }
+    for (int c : unusedBytes) {
+        classOf[c] = unused();
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef REGEX_NFA_BYTECLASSES_HPP
+#define REGEX_NFA_BYTECLASSES_HPP
+
+#include <vector>
+#include <cstdint>
+#include "nfa.hpp"
+
+// Particion de los 256 bytes en clases de equivalencia: dos bytes comparten
+// clase si desde cada estado llevan exactamente a los mismos destinos. Las
+// clases se numeran por su menor byte, y la ultima reune los bytes que no
+// etiquetan ninguna arista (incluido '$'), de modo que las tablas indexadas
+// por clase tienen size() columnas en lugar de 256.
+class ByteClasses {
+public:
+    // Un solo grupo: todos los bytes en la clase "sin aristas".
+    ByteClasses();
+    explicit ByteClasses(const FlatNFA& flat);
+
+    uint16_t operator[](unsigned char c) const {
+        return classOf[c];
+    }
+
+    size_t size() const {
+        return reps.size() + 1;
+    }
+
+    // Clase de los bytes sin aristas; siempre size() - 1.
+    uint16_t unused() const {
+        return static_cast<uint16_t>(reps.size());
+    }
+
+    // Menor byte de la clase k, para k < unused().
+    unsigned char representative(size_t k) const {
+        return reps[k];
+    }
+
+    const std::vector<uint16_t>& table() const {
+        return classOf;
+    }
+
+private:
+    std::vector<uint16_t> classOf;
+    std::vector<unsigned char> reps;
+};
+
+#endif
@@ -0,0 +1,138 @@
+#include "cache.hpp"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+static const char CACHE_MAGIC[] = "regex-nfa-cache 1";
+static const char ENTRY_SUFFIX[] = ".entry";
+
+uint64_t hashKey(string_view key) {
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+CompileCache::CompileCache(const string& dir, uint64_t maxBytes) : dir(dir), maxBytes(maxBytes) {
+    error_code ec;
+    fs::create_directories(dir, ec);
+    if (!fs::is_directory(dir)) {
+        throw runtime_error("Cannot create cache directory " + dir);
+    }
+}
+
+string CompileCache::entryPath(const string& key) const {
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hashKey(key)));
+    return (fs::path(dir) / (string(name) + ENTRY_SUFFIX)).string();
+}
+
+// Formato de una entrada: la cabecera, la clave y los tamanos en tres lineas,
+// seguidos de los bytes de la salida y del DOT.
+bool CompileCache::lookup(const string& key, CacheEntry& entry) {
+    string path = entryPath(key);
+    ifstream file(path, ios::binary);
+    string magic, storedKey;
+    size_t outputSize = 0, dotSize = 0;
+    bool found = file && getline(file, magic) && magic == CACHE_MAGIC && getline(file, storedKey) && storedKey == key &&
+                 file >> outputSize >> dotSize >> entry.minStats.statesBefore >> entry.minStats.statesAfter &&
+                 file.get() == '\n';
+    if (found) {
+        entry.output.resize(outputSize);
+        entry.dot.resize(dotSize);
+        file.read(&entry.output[0], static_cast<streamsize>(outputSize));
+        found = static_cast<size_t>(file.gcount()) == outputSize;
+        file.read(&entry.dot[0], static_cast<streamsize>(dotSize));
+        found = found && static_cast<size_t>(file.gcount()) == dotSize && file.peek() == char_traits<char>::eof();
+    }
+    if (!found) {
+        misses++;
+        return false;
+    }
+    error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    hits++;
+    return true;
+}
+
+void CompileCache::store(const string& key, const CacheEntry& entry) {
+    string path = entryPath(key);
+    ostringstream tempName;
+    tempName << path << ".tmp." << this_thread::get_id() << "." << tempCounter++;
+    string temp = tempName.str();
+    {
+        ofstream file(temp, ios::binary);
+        file << CACHE_MAGIC << '\n' << key << '\n' << entry.output.size() << ' ' << entry.dot.size() << ' '
+             << entry.minStats.statesBefore << ' ' << entry.minStats.statesAfter << '\n';
+        file.write(entry.output.data(), static_cast<streamsize>(entry.output.size()));
+        file.write(entry.dot.data(), static_cast<streamsize>(entry.dot.size()));
+        if (!file) {
+            file.close();
+            error_code ec;
+            fs::remove(temp, ec);
+            return;
+        }
+    }
+    error_code ec;
+    fs::rename(temp, path, ec);
+    if (ec) {
+        fs::remove(temp, ec);
+        return;
+    }
+    stores++;
+}
+
+void CompileCache::trim() {
+    struct File {
+        fs::path path;
+        uint64_t size;
+        fs::file_time_type time;
+    };
+    vector<File> files;
+    uint64_t total = 0;
+    error_code ec;
+    for (auto& item : fs::directory_iterator(dir, ec)) {
+        if (!item.is_regular_file(ec) || item.path().extension() != ENTRY_SUFFIX) {
+            continue;
+        }
+        File f{item.path(), item.file_size(ec), item.last_write_time(ec)};
+        total += f.size;
+        files.push_back(f);
+    }
+    if (total <= maxBytes) {
+        return;
+    }
+    sort(files.begin(), files.end(), [](const File& a, const File& b) {
+        return a.time < b.time;
+    });
+    for (auto& f : files) {
+        if (total <= maxBytes) {
+            break;
+        }
+        if (fs::remove(f.path, ec)) {
+            total -= f.size;
+            evictions++;
+            bytesEvicted += f.size;
+        }
+    }
+}
+
+CacheStats CompileCache::stats() const {
+    CacheStats s;
+    s.hits = hits;
+    s.misses = misses;
+    s.stores = stores;
+    s.evictions = evictions;
+    s.bytesEvicted = bytesEvicted;
+    return s;
+}
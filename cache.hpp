@@ -0,0 +1,58 @@
+#ifndef REGEX_NFA_CACHE_HPP
+#define REGEX_NFA_CACHE_HPP
+
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <cstdint>
+#include "dfa.hpp"
+
+// Resultado ya serializado de una compilacion.
+struct CacheEntry {
+    std::string output;         // bytes exactos del archivo de salida (o de la linea NDJSON)
+    std::string dot;            // descripcion DOT; vacia en modo por lotes
+    MinimizeStats minStats;
+};
+
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t stores = 0;
+    uint64_t evictions = 0;
+    uint64_t bytesEvicted = 0;
+};
+
+// FNV-1a de 64 bits; da el nombre del archivo de cada entrada.
+uint64_t hashKey(std::string_view key);
+
+// Cache de compilaciones en disco: una entrada <hash>.entry por clave, que se
+// guarda completa dentro del archivo para descartar colisiones. lookup y store
+// pueden llamarse desde varios hilos; las escrituras van a un temporal que
+// luego se renombra. Cada acierto actualiza la fecha de modificacion, y trim()
+// borra las entradas mas antiguas hasta que el directorio quepa en maxBytes.
+class CompileCache {
+public:
+    static constexpr uint64_t DEFAULT_MAX_BYTES = 64 * 1024 * 1024;
+
+    explicit CompileCache(const std::string& dir, uint64_t maxBytes = DEFAULT_MAX_BYTES);
+
+    bool lookup(const std::string& key, CacheEntry& entry);
+    void store(const std::string& key, const CacheEntry& entry);
+    void trim();
+
+    CacheStats stats() const;
+
+private:
+    std::string dir;
+    uint64_t maxBytes;
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> stores{0};
+    std::atomic<uint64_t> tempCounter{0};
+    uint64_t evictions = 0;
+    uint64_t bytesEvicted = 0;
+
+    std::string entryPath(const std::string& key) const;
+};
+
+#endif
@@ -0,0 +1,134 @@
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "nfa.hpp"
+#include "pikevm.hpp"
+#include "bitnfa.hpp"
+#include "lazydfa.hpp"
+#include "dfa.hpp"
+#include "epsilon.hpp"
+#include "binfmt.hpp"
+#include "regexset.hpp"
+#include "prefilter.hpp"
+#include "regexgen.hpp"
+
+using namespace std;
+
+// Compara todos los motores sobre expresiones de regex_nfa_gen con semillas
+// fijas: match() de PikeVM, BitParallelNFA, LazyDFA (con cache normal y con
+// una tan chica que se vacia seguido), el AFD, el AFD minimizado y el NFA sin
+// transiciones epsilon, y search() de los motores que lo tienen. El NFA y el AFD
+// tambien se leen de vuelta del formato binario (saveBinary/MappedAutomaton).
+// Las expresiones de cada largo forman ademas un RegexSet, cuyos ids deben ser
+// los de las expresiones que aceptan segun su PikeVM. Devuelve 1 ante el primer desacuerdo.
+
+// Todas las cadenas de largo 0..maxLen sobre "abcd": 'd' no aparece en las
+// expresiones, asi se cubren tambien los bytes sin aristas.
+static vector<string> inputs(size_t maxLen) {
+    vector<string> all = {""};
+    for (size_t begin = 0, end = 1, len = 1; len <= maxLen; ++len) {
+        for (size_t i = begin; i < end; ++i) {
+            for (char c : string("abcd")) {
+                all.push_back(all[i] + c);
+            }
+        }
+        begin = end;
+        end = all.size();
+    }
+    return all;
+}
+
+static bool report(const string& regEx, const string& text, const char* mode,
+                   const vector<pair<const char*, bool>>& results) {
+    for (auto& r : results) {
+        if (r.second != results[0].second) {
+            cerr << "Mismatch (" << mode << ") for regex \"" << regEx << "\" on \"" << text << "\":";
+            for (auto& e : results) {
+                cerr << " " << e.first << "=" << e.second;
+            }
+            cerr << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    const size_t PER_LENGTH = 100;
+    const vector<string> texts = inputs(4);
+    const string binPath = "regex_nfa_crosscheck.bin";
+    size_t regexes = 0, checks = 0;
+    for (size_t length = 1; length <= 12; ++length) {
+        GeneratorOptions opts;
+        opts.seed = length;
+        opts.length = length;
+        opts.maxDepth = 4;
+        opts.symbols = "abc";
+        opts.epsilonRate = 0.1;
+        RegexGenerator gen(opts);
+        vector<string> patterns;
+        vector<vector<uint32_t>> expectMatches(texts.size()), expectSearch(texts.size());
+        for (size_t n = 0; n < PER_LENGTH; ++n) {
+            string regEx = gen.next();
+            patterns.push_back(regEx);
+            NFA nfa = thompson(regEx);
+            nfa.getAlph(regEx);
+            PikeVM pike(nfa.flat);
+            BitParallelNFA bits(nfa.flat);
+            LazyDFA lazy(nfa.flat);
+            LazyDFA lazySmall(nfa.flat, 512);
+            DFA dfa = toDFA(nfa);
+            DFA minDfa = minimize(dfa);
+            NFA noEps = removeEpsilon(nfa);
+            saveBinary(binPath, nfa, &dfa);
+            MappedAutomaton mapped(binPath);
+            // El mapeo (o la copia, sin mmap) sigue valido sin el archivo.
+            remove(binPath.c_str());
+            const DFAView& mappedDfa = mapped.dfa();
+            PikeVM mappedPike(mapped.nfa().toFlat());
+            PrefilteredSearch filtered(regEx);
+            regexes++;
+            for (size_t t = 0; t < texts.size(); ++t) {
+                const string& text = texts[t];
+                bool ok = report(regEx, text, "match",
+                                 {{"pikevm", pike.match(text)},
+                                  {"bitnfa", bits.match(text)},
+                                  {"lazydfa", lazy.match(text)},
+                                  {"lazydfa_small", lazySmall.match(text)},
+                                  {"dfa", dfa.match(text)},
+                                  {"min_dfa", minDfa.match(text)},
+                                  {"no_eps", noEps.match(text)},
+                                  {"mapped_dfa", mappedDfa.match(text)},
+                                  {"mapped_nfa", mappedPike.match(text)}});
+                ok = ok && report(regEx, text, "search",
+                                  {{"pikevm", pike.search(text)},
+                                   {"bitnfa", bits.search(text)},
+                                   {"lazydfa", lazy.search(text)},
+                                   {"lazydfa_small", lazySmall.search(text)},
+                                   {"prefilter", filtered.search(text)},
+                                   {"mapped_nfa", mappedPike.search(text)}});
+                if (!ok) {
+                    return 1;
+                }
+                if (pike.match(text)) {
+                    expectMatches[t].push_back(static_cast<uint32_t>(n));
+                }
+                if (pike.search(text)) {
+                    expectSearch[t].push_back(static_cast<uint32_t>(n));
+                }
+                checks++;
+            }
+        }
+        RegexSet set(patterns);
+        for (size_t t = 0; t < texts.size(); ++t) {
+            if (set.matches(texts[t]) != expectMatches[t] || set.search(texts[t]) != expectSearch[t]) {
+                cerr << "Mismatch (regexset) for the " << patterns.size() << " regexes of length " << length
+                     << " on \"" << texts[t] << "\"" << endl;
+                return 1;
+            }
+        }
+    }
+    cout << regexes << " regexes, " << checks << " inputs: all engines agree" << endl;
+    return 0;
+}
@@ -0,0 +1,336 @@
+#include "dfa.hpp"
+#include "pikevm.hpp"
+#include "byteclasses.hpp"
+#include <map>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+bool DFA::match(string_view input) const {
+    if (size() == 0) {
+        return false;
+    }
+    int32_t s = start;
+    for (char ch : input) {
+        s = table[s * numClasses + classOf[static_cast<unsigned char>(ch)]];
+        if (s < 0) {
+            return false;
+        }
+    }
+    return accept[s] != 0;
+}
+
+NFA DFA::toNFA() const {
+    NFA nfa;
+    vector<State*> nodes;
+    nodes.reserve(size());
+    for (size_t s = 0; s < size(); ++s) {
+        nodes.push_back(nfa.newState());
+    }
+    // Una arista por byte, no por clase, en orden creciente de byte.
+    size_t unusedClass = numClasses - 1;
+    for (size_t s = 0; s < size(); ++s) {
+        for (int c = 0; c < 256; ++c) {
+            size_t k = classOf[c];
+            int32_t t = k == unusedClass ? -1 : table[s * numClasses + k];
+            if (t >= 0) {
+                nfa.addTransition(nodes[s], nodes[t], static_cast<char>(c));
+            }
+        }
+        if (accept[s]) {
+            nfa.makeAccept(nodes[s]);
+        }
+    }
+    for (int c = 0; c < 256; ++c) {
+        if (numClasses > 0 && classOf[c] != unusedClass) {
+            nfa.alphabet.insert(static_cast<char>(c));
+        }
+    }
+    if (!nodes.empty()) {
+        nfa.makeStart(nodes[start]);
+    }
+    nfa.finalize();
+    return nfa;
+}
+
+// Une las clases de simbolos cuyas columnas coinciden en todos los estados
+// (por ejemplo, a y b en (a+b)*c). La clase de los bytes sin aristas se
+// conserva aparte para que toNFA siga viendo todo el alfabeto.
+static void mergeClasses(DFA& dfa) {
+    size_t n = dfa.size();
+    size_t symbols = dfa.numClasses == 0 ? 0 : dfa.numClasses - 1;
+    if (symbols < 2) {
+        return;
+    }
+    map<vector<int32_t>, uint16_t> ids;
+    vector<uint16_t> remap(dfa.numClasses);
+    vector<size_t> firstOld;
+    vector<int32_t> column(n);
+    for (size_t k = 0; k < symbols; ++k) {
+        for (size_t s = 0; s < n; ++s) {
+            column[s] = dfa.table[s * dfa.numClasses + k];
+        }
+        auto it = ids.emplace(column, static_cast<uint16_t>(firstOld.size())).first;
+        if (it->second == firstOld.size()) {
+            firstOld.push_back(k);
+        }
+        remap[k] = it->second;
+    }
+    if (firstOld.size() == symbols) {
+        return;
+    }
+    remap[symbols] = static_cast<uint16_t>(firstOld.size());
+    size_t numClasses = firstOld.size() + 1;
+    vector<int32_t> table;
+    table.reserve(n * numClasses);
+    for (size_t s = 0; s < n; ++s) {
+        for (auto k : firstOld) {
+            table.push_back(dfa.table[s * dfa.numClasses + k]);
+        }
+        table.push_back(-1);
+    }
+    vector<unsigned char> reps;
+    for (auto k : firstOld) {
+        reps.push_back(dfa.classSymbols[k]);
+    }
+    for (auto& c : dfa.classOf) {
+        c = remap[c];
+    }
+    dfa.table = move(table);
+    dfa.classSymbols = move(reps);
+    dfa.numClasses = numClasses;
+}
+
+DFA toDFA(const NFA& nfa, size_t maxStates) {
+    const FlatNFA& flat = nfa.flat;
+    DFA dfa;
+    ByteClasses classes(flat);
+    dfa.classOf = classes.table();
+    for (size_t k = 0; k < classes.unused(); ++k) {
+        dfa.classSymbols.push_back(classes.representative(k));
+    }
+    dfa.numClasses = classes.size();
+    if (flat.size() == 0) {
+        return dfa;
+    }
+
+    vector<uint32_t> closureOffsets, closureStates;
+    epsilonClosureLists(flat, closureOffsets, closureStates);
+    vector<char> isAccept(flat.size(), 0);
+    for (auto s : flat.accept) {
+        isAccept[s] = 1;
+    }
+
+    map<vector<uint32_t>, int32_t> ids;
+    vector<vector<uint32_t>> sets;
+    auto intern = [&](vector<uint32_t>& set) {
+        sort(set.begin(), set.end());
+        set.erase(unique(set.begin(), set.end()), set.end());
+        auto it = ids.find(set);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        if (sets.size() >= maxStates) {
+            throw length_error("DFA state limit exceeded");
+        }
+        int32_t id = static_cast<int32_t>(sets.size());
+        ids.emplace(set, id);
+        bool acc = false;
+        for (auto s : set) {
+            acc = acc || isAccept[s];
+        }
+        dfa.accept.push_back(acc);
+        sets.push_back(set);
+        return id;
+    };
+
+    vector<uint32_t> startSet(closureStates.begin() + closureOffsets[flat.start],
+                              closureStates.begin() + closureOffsets[flat.start + 1]);
+    dfa.start = intern(startSet);
+
+    size_t symbols = dfa.numClasses - 1;
+    vector<vector<uint32_t>> buckets(symbols);
+    for (size_t s = 0; s < sets.size(); ++s) {
+        for (auto& b : buckets) {
+            b.clear();
+        }
+        for (auto x : sets[s]) {
+            for (uint32_t e = flat.offsets[x]; e < flat.offsets[x + 1]; ++e) {
+                // Los bytes de una clase tienen las mismas aristas: basta su representante.
+                unsigned char c = flat.labels[e];
+                if (c == '$' || classes.representative(dfa.classOf[c]) != c) {
+                    continue;
+                }
+                uint32_t t = flat.targets[e];
+                auto& b = buckets[dfa.classOf[c]];
+                b.insert(b.end(), closureStates.begin() + closureOffsets[t], closureStates.begin() + closureOffsets[t + 1]);
+            }
+        }
+        for (size_t k = 0; k < symbols; ++k) {
+            dfa.table.push_back(buckets[k].empty() ? -1 : intern(buckets[k]));
+        }
+        dfa.table.push_back(-1);
+    }
+    mergeClasses(dfa);
+    return dfa;
+}
+
+DFA minimize(const DFA& dfa, MinimizeStats* stats) {
+    size_t n = dfa.size();
+    size_t symbols = dfa.numClasses == 0 ? 0 : dfa.numClasses - 1;
+    if (stats) {
+        stats->statesBefore = n;
+        stats->statesAfter = n;
+    }
+    if (n == 0) {
+        return dfa;
+    }
+
+    // Se completa el automata con un estado muerto (n) y se invierten las
+    // transiciones por clase.
+    size_t total = n + 1;
+    vector<vector<uint32_t>> inverseOffsets(symbols, vector<uint32_t>(total + 1, 0));
+    vector<vector<uint32_t>> inverse(symbols, vector<uint32_t>(total));
+    auto target = [&](size_t s, size_t k) -> uint32_t {
+        if (s == n) {
+            return static_cast<uint32_t>(n);
+        }
+        int32_t t = dfa.table[s * dfa.numClasses + k];
+        return t < 0 ? static_cast<uint32_t>(n) : static_cast<uint32_t>(t);
+    };
+    for (size_t k = 0; k < symbols; ++k) {
+        auto& offsets = inverseOffsets[k];
+        for (size_t s = 0; s < total; ++s) {
+            offsets[target(s, k) + 1]++;
+        }
+        for (size_t t = 0; t < total; ++t) {
+            offsets[t + 1] += offsets[t];
+        }
+        vector<uint32_t> fillPos(offsets.begin(), offsets.end() - 1);
+        for (size_t s = 0; s < total; ++s) {
+            inverse[k][fillPos[target(s, k)]++] = static_cast<uint32_t>(s);
+        }
+    }
+
+    // Particion: elems es una permutacion de los estados donde cada bloque
+    // ocupa [first[b], last[b]); los marcados se mueven al principio del bloque.
+    vector<uint32_t> elems, loc(total), blockOf(total);
+    vector<uint32_t> first, last, marked;
+    vector<char> inWork;
+    vector<uint32_t> work;
+    for (int pass = 0; pass < 2; ++pass) {
+        uint32_t b = static_cast<uint32_t>(first.size());
+        uint32_t begin = static_cast<uint32_t>(elems.size());
+        for (size_t s = 0; s < total; ++s) {
+            bool acc = s < n && dfa.accept[s];
+            if (acc == (pass == 0)) {
+                loc[s] = static_cast<uint32_t>(elems.size());
+                blockOf[s] = b;
+                elems.push_back(static_cast<uint32_t>(s));
+            }
+        }
+        if (elems.size() > begin) {
+            first.push_back(begin);
+            last.push_back(static_cast<uint32_t>(elems.size()));
+            marked.push_back(0);
+            inWork.push_back(0);
+        }
+    }
+    uint32_t smallest = 0;
+    for (uint32_t b = 1; b < first.size(); ++b) {
+        if (last[b] - first[b] < last[smallest] - first[smallest]) {
+            smallest = b;
+        }
+    }
+    work.push_back(smallest);
+    inWork[smallest] = 1;
+
+    vector<uint32_t> splitter, touched;
+    while (!work.empty()) {
+        uint32_t a = work.back();
+        work.pop_back();
+        inWork[a] = 0;
+        splitter.assign(elems.begin() + first[a], elems.begin() + last[a]);
+        for (size_t k = 0; k < symbols; ++k) {
+            touched.clear();
+            for (auto t : splitter) {
+                for (uint32_t i = inverseOffsets[k][t]; i < inverseOffsets[k][t + 1]; ++i) {
+                    uint32_t p = inverse[k][i];
+                    uint32_t b = blockOf[p];
+                    uint32_t j = first[b] + marked[b];
+                    uint32_t q = elems[j];
+                    swap(elems[loc[p]], elems[j]);
+                    loc[q] = loc[p];
+                    loc[p] = j;
+                    if (marked[b]++ == 0) {
+                        touched.push_back(b);
+                    }
+                }
+            }
+            for (auto b : touched) {
+                uint32_t m = marked[b];
+                marked[b] = 0;
+                if (m == last[b] - first[b]) {
+                    continue;
+                }
+                uint32_t nb = static_cast<uint32_t>(first.size());
+                first.push_back(first[b]);
+                last.push_back(first[b] + m);
+                marked.push_back(0);
+                inWork.push_back(0);
+                first[b] += m;
+                for (uint32_t i = first[nb]; i < last[nb]; ++i) {
+                    blockOf[elems[i]] = nb;
+                }
+                if (inWork[b]) {
+                    work.push_back(nb);
+                    inWork[nb] = 1;
+                } else {
+                    uint32_t pick = (last[nb] - first[nb] <= last[b] - first[b]) ? nb : b;
+                    work.push_back(pick);
+                    inWork[pick] = 1;
+                }
+            }
+        }
+    }
+
+    // Renumera los bloques en orden BFS desde el inicial y descarta el del
+    // estado muerto.
+    uint32_t deadBlock = blockOf[n];
+    vector<int32_t> newId(first.size(), -1);
+    vector<uint32_t> order = {blockOf[dfa.start]};
+    newId[order[0]] = 0;
+    DFA res;
+    res.classOf = dfa.classOf;
+    res.classSymbols = dfa.classSymbols;
+    res.numClasses = dfa.numClasses;
+    res.start = 0;
+    if (order[0] == deadBlock) {
+        res.accept.push_back(0);
+        res.table.assign(res.numClasses, -1);
+    } else {
+        for (size_t i = 0; i < order.size(); ++i) {
+            uint32_t rep = elems[first[order[i]]];
+            res.accept.push_back(dfa.accept[rep]);
+            for (size_t k = 0; k < symbols; ++k) {
+                uint32_t tb = blockOf[target(rep, k)];
+                if (tb == deadBlock) {
+                    res.table.push_back(-1);
+                    continue;
+                }
+                if (newId[tb] < 0) {
+                    newId[tb] = static_cast<int32_t>(order.size());
+                    order.push_back(tb);
+                }
+                res.table.push_back(newId[tb]);
+            }
+            res.table.push_back(-1);
+        }
+    }
+    if (stats) {
+        stats->statesAfter = res.size();
+    }
+    mergeClasses(res);
+    return res;
+}
@@ -0,0 +1,48 @@
+#ifndef REGEX_NFA_DFA_HPP
+#define REGEX_NFA_DFA_HPP
+
+#include <vector>
+#include <string_view>
+#include <cstdint>
+#include "nfa.hpp"
+
+// DFA con tabla densa indexada por (estado, clase de bytes). Los simbolos que
+// se comportan igual en todos los estados comparten clase (ver ByteClasses),
+// y los bytes que no etiquetan ninguna arista caen en la ultima, cuya columna
+// es siempre -1 (sin transicion).
+struct DFA {
+    std::vector<uint16_t> classOf;              // 256 entradas
+    std::vector<unsigned char> classSymbols;    // menor simbolo de cada clase, salvo la ultima
+    size_t numClasses = 0;
+    std::vector<int32_t> table;                 // size() * numClasses
+    std::vector<char> accept;
+    int32_t start = 0;
+
+    size_t size() const {
+        return accept.size();
+    }
+
+    int32_t next(int32_t s, unsigned char c) const {
+        return table[s * numClasses + classOf[c]];
+    }
+
+    bool match(std::string_view input) const;
+    // Construye un NFA equivalente para exportarlo con nfaJson/visualize_nfa.
+    NFA toNFA() const;
+};
+
+struct MinimizeStats {
+    size_t statesBefore = 0;
+    size_t statesAfter = 0;
+
+    size_t removed() const {
+        return statesBefore - statesAfter;
+    }
+};
+
+DFA toDFA(const NFA& nfa, size_t maxStates = 100000);
+// Minimizacion de Hopcroft por refinamiento de particiones, O(n k log n).
+// Los estados desde los que no se alcanza la aceptacion se eliminan.
+DFA minimize(const DFA& dfa, MinimizeStats* stats = nullptr);
+
+#endif
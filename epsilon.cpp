@@ -0,0 +1,138 @@
+#include "epsilon.hpp"
+#include <algorithm>
+#include <set>
+
+using namespace std;
+
+EpsilonClosure::EpsilonClosure(const FlatNFA& flat)
+    : W(max<size_t>(1, (flat.size() + 63) / 64)), component(flat.size(), UINT32_MAX) {
+    const uint32_t UNVISITED = UINT32_MAX;
+    size_t n = flat.size();
+    vector<uint32_t> index(n, UNVISITED), low(n, 0);
+    vector<char> onStack(n, 0);
+    vector<uint32_t> sccStack;
+    vector<pair<uint32_t, uint32_t>> callStack;  // (estado, siguiente arista)
+    uint32_t counter = 0;
+
+    for (uint32_t root = 0; root < n; ++root) {
+        if (index[root] != UNVISITED) {
+            continue;
+        }
+        callStack.push_back({root, flat.offsets[root]});
+        index[root] = low[root] = counter++;
+        sccStack.push_back(root);
+        onStack[root] = 1;
+        while (!callStack.empty()) {
+            uint32_t v = callStack.back().first;
+            uint32_t& e = callStack.back().second;
+            if (e < flat.offsets[v + 1]) {
+                uint32_t w = flat.targets[e];
+                bool epsilon = flat.labels[e] == '$';
+                e++;
+                if (!epsilon) {
+                    continue;
+                }
+                if (index[w] == UNVISITED) {
+                    index[w] = low[w] = counter++;
+                    sccStack.push_back(w);
+                    onStack[w] = 1;
+                    callStack.push_back({w, flat.offsets[w]});
+                } else if (onStack[w]) {
+                    low[v] = min(low[v], index[w]);
+                }
+                continue;
+            }
+
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                uint32_t parent = callStack.back().first;
+                low[parent] = min(low[parent], low[v]);
+            }
+            if (low[v] != index[v]) {
+                continue;
+            }
+
+            uint32_t c = static_cast<uint32_t>(rows.size() / W);
+            rows.resize(rows.size() + W, 0);
+            size_t top = sccStack.size();
+            uint32_t u;
+            do {
+                u = sccStack[--top];
+                onStack[u] = 0;
+                component[u] = c;
+                rows[c * W + u / 64] |= uint64_t(1) << (u % 64);
+            } while (u != v);
+            for (size_t i = top; i < sccStack.size(); ++i) {
+                u = sccStack[i];
+                for (uint32_t f = flat.offsets[u]; f < flat.offsets[u + 1]; ++f) {
+                    uint32_t d = component[flat.targets[f]];
+                    if (flat.labels[f] != '$' || d == c) {
+                        continue;
+                    }
+                    for (size_t w = 0; w < W; ++w) {
+                        rows[c * W + w] |= rows[d * W + w];
+                    }
+                }
+            }
+            sccStack.resize(top);
+        }
+    }
+}
+
+NFA removeEpsilon(const NFA& nfa) {
+    const FlatNFA& flat = nfa.flat;
+    NFA res;
+    for (char c : nfa.alphabet) {
+        if (c != '$') {
+            res.alphabet.insert(c);
+        }
+    }
+    size_t n = flat.size();
+    if (n == 0) {
+        res.finalize();
+        return res;
+    }
+
+    EpsilonClosure closure(flat);
+    vector<char> isAccept(n, 0);
+    for (auto s : flat.accept) {
+        isAccept[s] = 1;
+    }
+
+    vector<char> kept(n, 0);
+    kept[flat.start] = 1;
+    for (size_t e = 0; e < flat.targets.size(); ++e) {
+        if (flat.labels[e] != '$') {
+            kept[flat.targets[e]] = 1;
+        }
+    }
+    vector<State*> nodes(n, nullptr);
+    for (uint32_t s = 0; s < n; ++s) {
+        if (kept[s]) {
+            nodes[s] = res.newState();
+        }
+    }
+
+    set<pair<unsigned char, uint32_t>> edges;
+    for (uint32_t p = 0; p < n; ++p) {
+        if (!kept[p]) {
+            continue;
+        }
+        edges.clear();
+        bool acc = false;
+        closure.forEach(p, [&](uint32_t q) {
+            acc = acc || isAccept[q];
+            for (uint32_t e = flat.offsets[q]; e < flat.offsets[q + 1]; ++e) {
+                if (flat.labels[e] != '$' && edges.insert({flat.labels[e], flat.targets[e]}).second) {
+                    res.addTransition(nodes[p], nodes[flat.targets[e]], static_cast<char>(flat.labels[e]));
+                }
+            }
+        });
+        if (acc) {
+            res.makeAccept(nodes[p]);
+        }
+    }
+    res.makeStart(nodes[flat.start]);
+    res.finalize();
+    return res;
+}
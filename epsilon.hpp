@@ -0,0 +1,55 @@
+#ifndef REGEX_NFA_EPSILON_HPP
+#define REGEX_NFA_EPSILON_HPP
+
+#include <vector>
+#include <cstdint>
+#include "nfa.hpp"
+
+// Clausuras epsilon de todos los estados, calculadas una sola vez como bitsets.
+// Las aristas '$' se condensan en componentes fuertemente conexas (Tarjan), de
+// modo que los ciclos de kleene_star se resuelven en un unico recorrido: cada
+// componente une sus miembros con las filas de sus sucesores, que ya estan
+// listas porque Tarjan emite las componentes en orden topologico inverso.
+class EpsilonClosure {
+public:
+    explicit EpsilonClosure(const FlatNFA& flat);
+
+    size_t words() const {
+        return W;
+    }
+
+    size_t components() const {
+        return rows.size() / W;
+    }
+
+    // Fila de W palabras con la clausura del estado s (compartida por su componente).
+    const uint64_t* row(uint32_t s) const {
+        return &rows[component[s] * W];
+    }
+
+    bool contains(uint32_t s, uint32_t t) const {
+        return (row(s)[t / 64] >> (t % 64)) & 1;
+    }
+
+    template <class F>
+    void forEach(uint32_t s, F f) const {
+        const uint64_t* r = row(s);
+        for (size_t w = 0; w < W; ++w) {
+            for (uint64_t x = r[w]; x != 0; x &= x - 1) {
+                f(static_cast<uint32_t>(w * 64 + __builtin_ctzll(x)));
+            }
+        }
+    }
+
+private:
+    size_t W;
+    std::vector<uint32_t> component;
+    std::vector<uint64_t> rows;
+};
+
+// Devuelve un NFA equivalente sin transiciones '$': conserva el estado inicial
+// y los destinos de aristas con simbolo, y cada uno hereda las aristas y la
+// aceptacion de su clausura.
+NFA removeEpsilon(const NFA& nfa);
+
+#endif
@@ -0,0 +1,113 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <stdexcept>
+#include "regexgen.hpp"
+#include "jsonwriter.hpp"
+
+using namespace std;
+
+// Pesos "concat:union:star", por ejemplo 3:2:1.
+static void parseMix(const string& mix, GeneratorOptions& opts) {
+    size_t a = mix.find(':');
+    size_t b = a == string::npos ? string::npos : mix.find(':', a + 1);
+    if (b == string::npos) {
+        throw invalid_argument("--mix expects concat:union:star");
+    }
+    opts.concatWeight = stod(mix.substr(0, a));
+    opts.unionWeight = stod(mix.substr(a + 1, b - a - 1));
+    opts.starWeight = stod(mix.substr(b + 1));
+}
+
+int main(int argc, char* argv[]) {
+    GeneratorOptions opts;
+    size_t count = 1;
+    string format = "json";
+    string output;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--seed" && hasValue) {
+                opts.seed = stoull(argv[++i]);
+            } else if (arg == "--count" && hasValue) {
+                count = stoull(argv[++i]);
+            } else if (arg == "--length" && hasValue) {
+                opts.length = stoull(argv[++i]);
+            } else if (arg == "--depth" && hasValue) {
+                opts.maxDepth = stoull(argv[++i]);
+            } else if (arg == "--star-nesting" && hasValue) {
+                opts.maxStarNesting = stoull(argv[++i]);
+            } else if (arg == "--mix" && hasValue) {
+                parseMix(argv[++i], opts);
+            } else if (arg == "--epsilon" && hasValue) {
+                opts.epsilonRate = stod(argv[++i]);
+            } else if (arg == "--symbols" && hasValue) {
+                opts.symbols = argv[++i];
+            } else if (arg == "--explicit-concat") {
+                opts.explicitConcat = true;
+            } else if (arg == "--format" && hasValue) {
+                format = argv[++i];
+            } else if (output.empty() && arg.compare(0, 2, "--") != 0) {
+                output = arg;
+            } else {
+                throw invalid_argument("Unknown argument: " + arg);
+            }
+        }
+        if (format != "json" && format != "ndjson" && format != "text") {
+            throw invalid_argument("--format must be json, ndjson or text");
+        }
+        RegexGenerator gen(opts);
+
+        ofstream file;
+        if (!output.empty()) {
+            file.open(output, ios::binary);
+            if (!file) {
+                throw runtime_error("Cannot open " + output);
+            }
+        }
+        OutputSink sink(output.empty() ? cout : file);
+        // json: la entrada de RegexNFA ({"regex": "..."} o {"regex": [...]}).
+        // ndjson: un objeto por linea. text: una expresion por linea.
+        JsonWriter w(sink, 0);
+        if (format == "json") {
+            w.beginObject();
+            w.key("regex");
+            if (count != 1) {
+                w.beginArray();
+            }
+        }
+        string regEx;
+        for (size_t i = 0; i < count; ++i) {
+            regEx.clear();
+            gen.next(regEx);
+            if (format == "text") {
+                sink.write(regEx);
+                sink.put('\n');
+            } else if (format == "ndjson") {
+                JsonWriter line(sink, 0);
+                line.beginObject();
+                line.key("regex");
+                line.value(regEx);
+                line.endObject();
+                sink.put('\n');
+            } else {
+                w.value(regEx);
+            }
+        }
+        if (format == "json") {
+            if (count != 1) {
+                w.endArray();
+            }
+            w.endObject();
+            sink.put('\n');
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        cerr << "Usage: regex_nfa_gen [--seed N] [--count N] [--length N] [--depth N] [--star-nesting N]"
+                " [--mix C:U:S] [--epsilon P] [--symbols S] [--explicit-concat] [--format json|ndjson|text]"
+                " [output]" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "jsonwriter.hpp"
+#include <charconv>
+#include <cstdio>
+#include <algorithm>
+
+using namespace std;
+
+void JsonWriter::newline(size_t depth) {
+    if (indent <= 0) {
+        return;
+    }
+    sink.put('\n');
+    for (size_t i = 0; i < depth * indent; ++i) {
+        sink.put(' ');
+    }
+}
+
+void JsonWriter::prefix() {
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    if (!levels.empty()) {
+        if (levels.back().count++ > 0) {
+            sink.put(',');
+        }
+        newline(levels.size());
+    }
+}
+
+void JsonWriter::open(char c) {
+    prefix();
+    sink.put(c);
+    levels.push_back({c == '{', 0});
+}
+
+void JsonWriter::close(char c) {
+    Level level = levels.back();
+    levels.pop_back();
+    if (level.count > 0) {
+        newline(levels.size());
+    }
+    sink.put(c);
+}
+
+void JsonWriter::key(string_view k) {
+    if (levels.back().count++ > 0) {
+        sink.put(',');
+    }
+    newline(levels.size());
+    quoted(k);
+    sink.put(':');
+    if (indent > 0) {
+        sink.put(' ');
+    }
+    afterKey = true;
+}
+
+void JsonWriter::quoted(string_view s) {
+    sink.put('"');
+    for (char ch : s) {
+        unsigned char c = static_cast<unsigned char>(ch);
+        if (c == '"' || c == '\\') {
+            sink.put('\\');
+            sink.put(ch);
+        } else if (c == '\n') {
+            sink.write("\\n");
+        } else if (c == '\t') {
+            sink.write("\\t");
+        } else if (c == '\r') {
+            sink.write("\\r");
+        } else if (c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            sink.write(buf);
+        } else {
+            sink.put(ch);
+        }
+    }
+    sink.put('"');
+}
+
+void JsonWriter::value(string_view s) {
+    prefix();
+    quoted(s);
+}
+
+void JsonWriter::value(uint64_t x) {
+    prefix();
+    char buf[24];
+    auto res = to_chars(buf, buf + sizeof(buf), x);
+    sink.write(string_view(buf, res.ptr - buf));
+}
+
+void JsonWriter::value(int64_t x) {
+    prefix();
+    char buf[24];
+    auto res = to_chars(buf, buf + sizeof(buf), x);
+    sink.write(string_view(buf, res.ptr - buf));
+}
+
+void JsonWriter::value(double x) {
+    prefix();
+    char buf[32];
+    int len = snprintf(buf, sizeof(buf), "%.17g", x);
+    sink.write(string_view(buf, static_cast<size_t>(len)));
+}
+
+void JsonWriter::value(double x, int decimals) {
+    prefix();
+    char buf[48];
+    int len = snprintf(buf, sizeof(buf), "%.*f", decimals, x);
+    sink.write(string_view(buf, min(static_cast<size_t>(len), sizeof(buf) - 1)));
+}
+
+void JsonWriter::value(bool b) {
+    prefix();
+    sink.write(b ? "true" : "false");
+}
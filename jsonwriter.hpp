@@ -0,0 +1,127 @@
+#ifndef REGEX_NFA_JSONWRITER_HPP
+#define REGEX_NFA_JSONWRITER_HPP
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// Buffer de salida propio: acumula los bytes y los vuelca al ostream por bloques.
+class OutputSink {
+public:
+    explicit OutputSink(std::ostream& out, size_t capacity = 1 << 16)
+        : out(&out), capacity(capacity), written(0) {
+        buffer.reserve(capacity);
+    }
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+
+    ~OutputSink() {
+        flush();
+    }
+
+    void write(std::string_view s) {
+        if (buffer.size() + s.size() > capacity) {
+            flush();
+            if (s.size() > capacity) {
+                out->write(s.data(), static_cast<std::streamsize>(s.size()));
+                written += s.size();
+                return;
+            }
+        }
+        buffer.append(s.data(), s.size());
+        written += s.size();
+    }
+
+    void put(char c) {
+        if (buffer.size() == capacity) {
+            flush();
+        }
+        buffer.push_back(c);
+        written++;
+    }
+
+    void flush() {
+        out->write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+
+    // Cambia el destino conservando el buffer reservado.
+    void reset(std::ostream& next) {
+        flush();
+        out = &next;
+    }
+
+    size_t bytesWritten() const {
+        return written;
+    }
+
+private:
+    std::ostream* out;
+    std::string buffer;
+    size_t capacity;
+    size_t written;
+};
+
+// Escritor JSON en una sola pasada, sin construir el documento en memoria.
+// Con indent > 0 reproduce el formato de nlohmann::json con setw(indent);
+// con indent == 0 escribe la forma compacta.
+class JsonWriter {
+public:
+    JsonWriter(OutputSink& sink, int indent = 4) : sink(sink), indent(indent) {}
+
+    void beginObject() {
+        open('{');
+    }
+
+    void endObject() {
+        close('}');
+    }
+
+    void beginArray() {
+        open('[');
+    }
+
+    void endArray() {
+        close(']');
+    }
+
+    void key(std::string_view k);
+    void value(std::string_view s);
+    void value(const char* s) {
+        value(std::string_view(s));
+    }
+    void value(uint64_t x);
+    void value(uint32_t x) {
+        value(static_cast<uint64_t>(x));
+    }
+    void value(int64_t x);
+    void value(int x) {
+        value(static_cast<int64_t>(x));
+    }
+    void value(double x);
+    // Con una cantidad fija de decimales, para valores que no necesitan
+    // reconstruirse exactos (tiempos).
+    void value(double x, int decimals);
+    void value(bool b);
+
+private:
+    struct Level {
+        bool object;
+        size_t count;
+    };
+
+    OutputSink& sink;
+    int indent;
+    std::vector<Level> levels;
+    bool afterKey = false;
+
+    void open(char c);
+    void close(char c);
+    void prefix();
+    void newline(size_t depth);
+    void quoted(std::string_view s);
+};
+
+#endif
@@ -0,0 +1,193 @@
+#include "lazydfa.hpp"
+#include <algorithm>
+
+using namespace std;
+
+// Si tras un vaciado de la cache se procesan menos de este numero de bytes por
+// estado construido, la cache no esta rindiendo y se usa el PikeVM.
+static const size_t MIN_BYTES_PER_STATE = 10;
+
+size_t LazyDFA::KeyHash::operator()(const vector<uint32_t>& key) const {
+    uint64_t h = 1469598103934665603ULL;
+    for (auto x : key) {
+        h = (h ^ x) * 1099511628211ULL;
+    }
+    return static_cast<size_t>(h);
+}
+
+LazyDFA::LazyDFA(const FlatNFA& flat, size_t cacheBytes)
+    : flat(flat), fallback(flat), isAccept(flat.size(), 0), budget(cacheBytes), usedBytes(0),
+      classes(flat), startState{UNKNOWN, UNKNOWN}, scratch(flat.size()), bytesSinceFlush(0), builtSinceFlush(0) {
+    for (auto s : flat.accept) {
+        isAccept[s] = 1;
+    }
+    epsilonClosureLists(flat, closureOffsets, closureStates);
+}
+
+void LazyDFA::flush() {
+    states.clear();
+    next.clear();
+    cache.clear();
+    usedBytes = 0;
+    startState[0] = startState[1] = UNKNOWN;
+    bytesSinceFlush = 0;
+    builtSinceFlush = 0;
+    counters.flushes++;
+}
+
+void LazyDFA::addClosure(uint32_t s) {
+    for (uint32_t i = closureOffsets[s]; i < closureOffsets[s + 1]; ++i) {
+        if (!scratch.contains(closureStates[i])) {
+            scratch.insert(closureStates[i]);
+        }
+    }
+}
+
+int32_t LazyDFA::intern(vector<uint32_t>& set, bool unanchored) {
+    set.push_back(unanchored ? 1 : 0);
+    auto it = cache.find(set);
+    if (it != cache.end()) {
+        return it->second;
+    }
+
+    size_t cost = sizeof(DState) + classes.size() * sizeof(int32_t) + 2 * set.size() * sizeof(uint32_t) + 64;
+    if (usedBytes + cost > budget) {
+        if (states.empty() || bytesSinceFlush < MIN_BYTES_PER_STATE * builtSinceFlush) {
+            return GIVE_UP;
+        }
+        flush();
+        if (cost > budget) {
+            return GIVE_UP;
+        }
+    }
+
+    int32_t id = static_cast<int32_t>(states.size());
+    cache.emplace(set, id);
+    set.pop_back();
+    states.emplace_back();
+    DState& d = states.back();
+    d.accept = false;
+    for (auto s : set) {
+        d.accept = d.accept || isAccept[s];
+    }
+    d.set = move(set);
+    d.unanchored = unanchored;
+    next.resize(next.size() + classes.size(), UNKNOWN);
+    usedBytes += cost;
+    builtSinceFlush++;
+    return id;
+}
+
+int32_t LazyDFA::start(bool unanchored) {
+    int32_t& s = startState[unanchored ? 1 : 0];
+    if (s == UNKNOWN) {
+        scratch.clear();
+        addClosure(flat.start);
+        vector<uint32_t> set;
+        for (size_t i = 0; i < scratch.size(); ++i) {
+            set.push_back(scratch[i]);
+        }
+        sort(set.begin(), set.end());
+        int32_t t = intern(set, unanchored);
+        if (t == GIVE_UP) {
+            return GIVE_UP;
+        }
+        startState[unanchored ? 1 : 0] = t;
+        return t;
+    }
+    return s;
+}
+
+int32_t LazyDFA::step(int32_t s, unsigned char c) {
+    bool unanchored = states[s].unanchored;
+    scratch.clear();
+    if (c != '$') {
+        for (auto x : states[s].set) {
+            for (uint32_t e = flat.offsets[x]; e < flat.offsets[x + 1]; ++e) {
+                if (flat.labels[e] == c) {
+                    addClosure(flat.targets[e]);
+                }
+            }
+        }
+    }
+    if (unanchored) {
+        addClosure(flat.start);
+    }
+    if (scratch.size() == 0 && !unanchored) {
+        next[s * classes.size() + classes[c]] = DEAD;
+        return DEAD;
+    }
+
+    vector<uint32_t> set;
+    set.reserve(scratch.size() + 1);
+    for (size_t i = 0; i < scratch.size(); ++i) {
+        set.push_back(scratch[i]);
+    }
+    sort(set.begin(), set.end());
+    uint64_t flushes = counters.flushes;
+    int32_t t = intern(set, unanchored);
+    if (t >= 0 && counters.flushes == flushes) {
+        next[s * classes.size() + classes[c]] = t;
+    }
+    return t;
+}
+
+bool LazyDFA::match(string_view input) {
+    if (flat.size() == 0) {
+        return false;
+    }
+    bytesSinceFlush = 0;
+    builtSinceFlush = 0;
+    size_t stride = classes.size();
+    int32_t s = start(false);
+    for (size_t i = 0; i < input.size() && s >= 0; ++i) {
+        unsigned char c = static_cast<unsigned char>(input[i]);
+        int32_t t = next[s * stride + classes[c]];
+        if (t == UNKNOWN) {
+            counters.misses++;
+            t = step(s, c);
+        } else {
+            counters.hits++;
+        }
+        if (t == DEAD) {
+            return false;
+        }
+        s = t;
+        bytesSinceFlush++;
+    }
+    if (s == GIVE_UP) {
+        counters.fallbacks++;
+        return fallback.match(input);
+    }
+    return states[s].accept;
+}
+
+bool LazyDFA::search(string_view input) {
+    if (flat.size() == 0) {
+        return false;
+    }
+    bytesSinceFlush = 0;
+    builtSinceFlush = 0;
+    size_t stride = classes.size();
+    int32_t s = start(true);
+    for (size_t i = 0; s >= 0; ++i) {
+        if (states[s].accept) {
+            return true;
+        }
+        if (i == input.size()) {
+            return false;
+        }
+        unsigned char c = static_cast<unsigned char>(input[i]);
+        int32_t t = next[s * stride + classes[c]];
+        if (t == UNKNOWN) {
+            counters.misses++;
+            t = step(s, c);
+        } else {
+            counters.hits++;
+        }
+        s = t;
+        bytesSinceFlush++;
+    }
+    counters.fallbacks++;
+    return fallback.search(input);
+}
@@ -0,0 +1,87 @@
+#ifndef REGEX_NFA_LAZYDFA_HPP
+#define REGEX_NFA_LAZYDFA_HPP
+
+#include <vector>
+#include <string_view>
+#include <unordered_map>
+#include <cstdint>
+#include "nfa.hpp"
+#include "pikevm.hpp"
+#include "byteclasses.hpp"
+
+struct LazyDFAStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t flushes = 0;
+    uint64_t fallbacks = 0;
+};
+
+// DFA construido bajo demanda: cada estado es un conjunto de estados del NFA
+// y sus transiciones se calculan la primera vez que se recorren. Los estados
+// viven en una cache acotada por cacheBytes; al llenarse se vacia por completo
+// y, si se vacia demasiado seguido para la entrada procesada, la busqueda se
+// repite con el PikeVM.
+class LazyDFA {
+public:
+    static constexpr size_t DEFAULT_CACHE_BYTES = 2 * 1024 * 1024;
+
+    explicit LazyDFA(const FlatNFA& flat, size_t cacheBytes = DEFAULT_CACHE_BYTES);
+
+    bool match(std::string_view input);
+    // Indica si alguna subcadena de la entrada pertenece al lenguaje.
+    bool search(std::string_view input);
+
+    const LazyDFAStats& stats() const {
+        return counters;
+    }
+
+    size_t cachedStates() const {
+        return states.size();
+    }
+
+    size_t cacheUsage() const {
+        return usedBytes;
+    }
+
+private:
+    static constexpr int32_t UNKNOWN = -1;
+    static constexpr int32_t DEAD = -2;
+    static constexpr int32_t GIVE_UP = -3;
+
+    struct DState {
+        std::vector<uint32_t> set;
+        bool unanchored;
+        bool accept;
+    };
+
+    struct KeyHash {
+        size_t operator()(const std::vector<uint32_t>& key) const;
+    };
+
+    FlatNFA flat;
+    PikeVM fallback;
+    std::vector<char> isAccept;
+    std::vector<uint32_t> closureOffsets;
+    std::vector<uint32_t> closureStates;
+    size_t budget;
+    size_t usedBytes;
+    std::vector<DState> states;
+    // Transiciones de todos los estados, una fila de classes.size() por estado.
+    ByteClasses classes;
+    std::vector<int32_t> next;
+    // La clave es el conjunto ordenado mas un ultimo elemento con el modo.
+    std::unordered_map<std::vector<uint32_t>, int32_t, KeyHash> cache;
+    int32_t startState[2];
+    SparseSet scratch;
+    size_t bytesSinceFlush;
+    size_t builtSinceFlush;
+    LazyDFAStats counters;
+
+    void flush();
+    int32_t intern(std::vector<uint32_t>& set, bool unanchored);
+    int32_t start(bool unanchored);
+    int32_t step(int32_t s, unsigned char c);
+    void addClosure(uint32_t s);
+};
+
+#endif
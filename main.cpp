@@ -1,324 +1,400 @@
 #include <iostream>
-#include <vector>
-#include <string>
 #include <fstream>
 #include <sstream>
-#include <unordered_map>
-#include <unordered_set>
-#include <stack>
-#include "json.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <stdexcept>
+#include "nfa.hpp"
+#include "dfa.hpp"
+#include "epsilon.hpp"
+#include "jsonwriter.hpp"
+#include "threadpool.hpp"
+#include "binfmt.hpp"
+#include "cache.hpp"
+#include "profile.hpp"
+#include "alloccount.hpp"
 
 using namespace std;
-using json = nlohmann::json;
-
-const string ALPHABET = "0123456789abcdefghijklmnopqrstuvwxyz*.+()$";
-const unordered_set<char> OPERATORS = {'*', '.', '+', '(', ')'};
-const unordered_map<char, int> PRIORITY = {{'*', 2}, {'.', 1}, {'+', 0}};
-const int INVALID_REGEX = -1;
-const int VALID_REGEX = 0;
-
-class State {
-public:
-    int id;
-    string name;
-    vector<pair<State*, char>> transitions;
-    static int count;
 
-    State() : id(count++), name("") {}
-
-    void addTransition(State* node, char alph) {
-        transitions.push_back({node, alph});
-    }
+struct Options {
+    bool dfa = false;
+    bool min = false;
+    bool noEps = false;
+    bool compact = false;
+    bool binary = false;
+    bool stats = false;
+    bool counters = false;
+    string traceFile;    // vacio: sin traza
+    size_t threads = 0;  // 0: todos los nucleos
+    string cacheDir;     // vacio: sin cache
+    uint64_t cacheBytes = CompileCache::DEFAULT_MAX_BYTES;
 };
 
-int State::count = 0;
-
-class NFA {
-public:
-    vector<State*> states;
-    State* start;
-    vector<State*> accept;
-    unordered_set<char> alphabet;
-
-    NFA() : start(nullptr) {}
+// Clave de la cache: la expresion normalizada por addConcat junto con todo lo
+// que cambia los bytes de salida.
+static string cacheKey(const string& regEx, const Options& opts, bool batch) {
+    string key = opts.min ? "min" : opts.dfa ? "dfa" : opts.noEps ? "noeps" : "nfa";
+    key += batch ? ":ndjson:" : opts.binary ? ":binary:" : opts.compact ? ":compact:" : ":json:";
+    return key + addConcat(regEx);
+}
 
-    void getAlph(const string& regex) {
-        for (char c : regex) {
-            if (OPERATORS.find(c) == OPERATORS.end() && alphabet.find(c) == alphabet.end()) {
-                alphabet.insert(c);
-            }
-        }
+// Si se pasa dfaOut, recibe el DFA de --dfa/--min (vacio en los demas modos).
+// Con profile, cada etapa suma su tiempo a la fase del mismo nombre.
+static NFA compile(const string& regEx, const Options& opts, const shared_ptr<StateArena>& arena, Profile* profile,
+                   MinimizeStats* minStats, DFA* dfaOut = nullptr) {
+    PhaseScope parse(profile, "parse");
+    vector<char> postfix;
+    if (parseRegEx(addConcat(regEx), postfix) == INVALID_REGEX) {
+        throw invalid_argument("Invalid regular expression");
     }
+    parse.stop();
 
-    void addState(State* s) {
-        states.push_back(s);
+    PhaseScope build(profile, "thompson");
+    NFA nfa = thompson(postfix, arena);
+    nfa.getAlph(regEx);
+    build.stop();
+    if (profile) {
+        profile->entries++;
+        profile->addAutomaton(nfa.flat, false);
     }
 
-    void addTransition(State* s1, State* s2, char a) {
-        s1->addTransition(s2, a);
+    if (opts.min || opts.dfa) {
+        PhaseScope convert(profile, opts.min ? "minimize" : "dfa");
+        DFA dfa = opts.min ? minimize(toDFA(nfa), minStats) : toDFA(nfa);
+        nfa = dfa.toNFA();
+        if (dfaOut) {
+            *dfaOut = move(dfa);
+        }
+    } else if (opts.noEps) {
+        PhaseScope convert(profile, "remove_epsilon");
+        nfa = removeEpsilon(nfa);
     }
 
-    void makeStart(State* s) {
-        start = s;
+    PhaseScope naming(profile, "names");
+    nfa.names();
+    naming.stop();
+    if (profile) {
+        profile->addAutomaton(nfa.flat, true);
     }
+    return nfa;
+}
 
-    void makeAccept(State* s) {
-        accept.push_back(s);
-    }
+static void writeError(OutputSink& sink, const string& message) {
+    JsonWriter w(sink, 0);
+    w.beginObject();
+    w.key("error");
+    w.value(message);
+    w.endObject();
+    sink.put('\n');
+}
 
-    void removeAccept(State* s) {
-        accept.erase(remove(accept.begin(), accept.end(), s), accept.end());
+// streambuf que agrega al final de un string, para que cada hilo escriba
+// todas sus entradas en un mismo bloque en lugar de un ostringstream por entrada.
+class AppendBuf : public streambuf {
+public:
+    explicit AppendBuf(string& out) : out(out) {}
+
+protected:
+    streamsize xsputn(const char* s, streamsize n) override {
+        out.append(s, static_cast<size_t>(n));
+        return n;
     }
 
-    void names() {
-        int c = 0;
-        start->name = "q" + to_string(c++);
-        vector<State*> states_queue = {start};
-        while (!states_queue.empty()) {
-            State* cur = states_queue.front();
-            states_queue.erase(states_queue.begin());
-            for (auto& transition : cur->transitions) {
-                State* state = transition.first;
-                if (state->name.empty()) {
-                    state->name = "q" + to_string(c++);
-                    states_queue.push_back(state);
-                }
-            }
+    int_type overflow(int_type c) override {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            out.push_back(traits_type::to_char_type(c));
         }
+        return c;
     }
 
-    void nfaJson(const string& path) {
-        json js;
-        for (auto state : states) {
-            js["states"].push_back(state->name);
-        }
-        for (char c : alphabet) {
-            js["letters"].push_back(string(1, c));
-        }
-        for (auto state : states) {
-            for (auto& transition : state->transitions) {
-                js["transition_function"].push_back({state->name, string(1, transition.second), transition.first->name});
-            }
-        }
-        js["start_states"] = {start->name};
-        for (auto state : accept) {
-            js["final_states"].push_back(state->name);
-        }
+private:
+    string& out;
+};
 
-        ofstream file(path);
-        file << setw(4) << js << endl;
-    }
+// Salida de un hilo del lote: el texto de todas sus entradas, en el orden en
+// que las compilo, y un unico sink que se reutiliza entre ellas.
+struct WorkerOutput {
+    string text;
+    AppendBuf buf{text};
+    ostream stream{&buf};
+    OutputSink sink{stream, 4096};
 };
 
-string addConcat(const string& regEx) {
-    string res;
-    for (size_t i = 0; i < regEx.size(); ++i) {
-        res.push_back(regEx[i]);
-        if (regEx[i] != '(' && regEx[i] != '.' && regEx[i] != '+') {
-            if (i + 1 < regEx.size() && regEx[i + 1] != ')' && regEx[i + 1] != '*' && regEx[i + 1] != '+' && regEx[i + 1] != '.') {
-                res.push_back('.');
-            }
-        }
+// Modo por lotes: un automata compacto por linea (NDJSON), en el orden de
+// entrada. Las expresiones se compilan en paralelo; cada hilo reutiliza su
+// propia arena de estados y su buffer de salida, y al final se concatenan los
+// tramos de cada entrada por indice. No se invoca graphviz. inputErrors trae
+// los errores de lectura de cada entrada (vacio si es valida).
+static int compileBatch(const vector<string>& regexes, const vector<string>& inputErrors, const Options& opts,
+                        const string& output_path, CompileCache* cache, Profile* profile) {
+    size_t threads = opts.threads != 0 ? opts.threads : max(1u, thread::hardware_concurrency());
+    WorkStealingPool pool(min(threads, max<size_t>(1, regexes.size())));
+    vector<shared_ptr<StateArena>> arenas;
+    vector<unique_ptr<WorkerOutput>> workers;
+    for (size_t w = 0; w < pool.size(); ++w) {
+        arenas.push_back(make_shared<StateArena>());
+        workers.push_back(make_unique<WorkerOutput>());
     }
-    return res;
-}
-
-int parseRegEx(const string& regEx, vector<char>& postfix) {
-    if (regEx.empty()) return VALID_REGEX;
-
-    for (char a : regEx) {
-        if (ALPHABET.find(a) == string::npos) {
-            return INVALID_REGEX;
+    // Tramo [begin, end) del texto de un hilo con la salida de cada entrada.
+    struct Slice {
+        size_t worker, begin, end;
+    };
+    vector<Slice> slices(regexes.size());
+    vector<string> errors = inputErrors;
+    pool.run(regexes.size(), [&](size_t i, size_t worker) {
+        TraceScope span(profile, "entry", static_cast<int64_t>(i));
+        WorkerOutput& out = *workers[worker];
+        size_t begin = out.text.size();
+        auto finish = [&] {
+            out.sink.flush();
+            slices[i] = {worker, begin, out.text.size()};
+        };
+        if (!errors[i].empty()) {
+            writeError(out.sink, errors[i]);
+            finish();
+            return;
         }
-    }
-
-    postfix.clear();
-    stack<char> stack;
-    for (char a : regEx) {
-        if (OPERATORS.find(a) == OPERATORS.end()) {
-            postfix.push_back(a);
-        } else if (a == '(') {
-            stack.push('(');
-        } else if (a == ')') {
-            while (!stack.empty() && stack.top() != '(') {
-                postfix.push_back(stack.top());
-                stack.pop();
-            }
-            stack.pop();
-        } else {
-            while (!stack.empty() && stack.top() != '(' && PRIORITY.at(a) <= PRIORITY.at(stack.top())) {
-                postfix.push_back(stack.top());
-                stack.pop();
+        CacheEntry entry;
+        string key = cache ? cacheKey(regexes[i], opts, true) : string();
+        PhaseScope lookup(cache ? profile : nullptr, "cache");
+        if (cache && cache->lookup(key, entry)) {
+            out.sink.write(entry.output);
+            finish();
+            return;
+        }
+        lookup.stop();
+        arenas[worker]->reset();
+        try {
+            NFA nfa = compile(regexes[i], opts, arenas[worker], profile, nullptr);
+            PhaseScope serialize(profile, "serialize");
+            nfa.writeJson(out.sink, true);
+            out.sink.flush();
+            serialize.stop();
+            if (cache) {
+                PhaseScope store(profile, "cache");
+                entry.output = out.text.substr(begin);
+                cache->store(key, entry);
             }
-            stack.push(a);
+        } catch (const exception& e) {
+            // Se descarta lo que se haya escrito de la entrada antes del error.
+            out.sink.flush();
+            out.text.resize(begin);
+            errors[i] = e.what();
+            writeError(out.sink, errors[i]);
         }
-    }
-    while (!stack.empty()) {
-        postfix.push_back(stack.top());
-        stack.pop();
-    }
-    return VALID_REGEX;
-}
-
-string readJSON(const string& path) {
-    ifstream file(path);
-    json data;
-    file >> data;
-    return data.value("regex", "");
-}
-
-void visualize_nfa(const json& nfa_json, const string& output_path) {
-    ofstream dot(output_path + ".dot");
-    dot << "digraph NFA {" << endl;
-    for (const auto& state : nfa_json["states"]) {
-        dot << "    " << state;
-        if (find(nfa_json["final_states"].begin(), nfa_json["final_states"].end(), state) != nfa_json["final_states"].end()) {
-            dot << " [shape=doublecircle]";
+        finish();
+    });
+
+    PhaseScope write(profile, "write");
+    ofstream file(output_path, ios::binary);
+    OutputSink sink(file);
+    int failed = 0;
+    for (size_t i = 0; i < regexes.size(); ++i) {
+        const Slice& slice = slices[i];
+        sink.write(string_view(workers[slice.worker]->text).substr(slice.begin, slice.end - slice.begin));
+        if (!errors[i].empty()) {
+            cerr << "Entry " << i << ": " << errors[i] << endl;
+            failed++;
         }
-        dot << ";" << endl;
-    }
-    for (const auto& transition : nfa_json["transition_function"]) {
-        string label = (transition[1] == "$") ? "ε" : transition[1].get<string>();
-        dot << "    " << transition[0] << " -> " << transition[2] << " [label=\"" << label << "\"];" << endl;
     }
-    for (const auto& start_state : nfa_json["start_states"]) {
-        dot << "    start [shape=point];" << endl;
-        dot << "    start -> " << start_state << ";" << endl;
+    sink.flush();
+    if (profile) {
+        profile->bytesWritten += sink.bytesWritten();
     }
-    dot << "}" << endl;
-    dot.close();
-    string cmd = "dot -Tpng " + output_path + ".dot -o " + output_path + ".png";
-    system(cmd.c_str());
-    remove((output_path + ".dot").c_str());
+    return failed == 0 ? 0 : 1;
 }
 
-NFA kleene_base_cases(char symbol) {
-    NFA nfa;
-    if (symbol == '$') {
-        State* start_state = new State();
-        nfa.addState(start_state);
-        nfa.makeStart(start_state);
-        nfa.makeAccept(start_state);
-        return nfa;
-    }
-    if (symbol == '\0' || symbol == ' ') {
-        State* start_state = new State();
-        nfa.addState(start_state);
-        nfa.makeStart(start_state);
-        return nfa;
-    } else {
-        State* q0 = new State();
-        nfa.addState(q0);
-        nfa.makeStart(q0);
-        State* q1 = new State();
-        nfa.addState(q1);
-        nfa.makeAccept(q1);
-        nfa.addTransition(q0, q1, symbol);
-        return nfa;
+static void writeFile(const string& path, const string& bytes, Profile* profile) {
+    ofstream file(path, ios::binary);
+    file.write(bytes.data(), static_cast<streamsize>(bytes.size()));
+    if (profile) {
+        profile->bytesWritten += bytes.size();
     }
 }
 
-NFA kleene_union(NFA& nfa1, NFA& nfa2) {
-    NFA nfa;
-    State* start = new State();
-    nfa.addState(start);
-    nfa.makeStart(start);
-    nfa.addTransition(start, nfa1.start, '$');
-    nfa.addTransition(start, nfa2.start, '$');
-    nfa.states.insert(nfa.states.end(), nfa1.states.begin(), nfa1.states.end());
-    nfa.states.insert(nfa.states.end(), nfa2.states.begin(), nfa2.states.end());
-    nfa.accept.insert(nfa.accept.end(), nfa1.accept.begin(), nfa1.accept.end());
-    nfa.accept.insert(nfa.accept.end(), nfa2.accept.begin(), nfa2.accept.end());
-    return nfa;
-}
-
-NFA kleene_concat(NFA& nfa1, NFA& nfa2) {
-    NFA nfa;
-    nfa.states.insert(nfa.states.end(), nfa1.states.begin(), nfa1.states.end());
-    nfa.states.insert(nfa.states.end(), nfa2.states.begin(), nfa2.states.end());
-    nfa.start = nfa1.start;
-    nfa.accept = nfa2.accept;
-    for (auto accept_state : nfa1.accept) {
-        accept_state->addTransition(nfa2.start, '$');
+// Salida y DOT de una expresion, en memoria o directo a los archivos. Devuelve
+// los bytes producidos; bytesWritten lo suma quien los escribe a disco.
+static size_t serialize(const NFA& nfa, const DFA& dfa, const Options& opts, ostream& out, ostream& dot,
+                      Profile* profile) {
+    PhaseScope phase(profile, "serialize");
+    OutputSink sink(out);
+    if (opts.binary) {
+        writeBinary(sink, nfa, &dfa);
+    } else {
+        nfa.writeJson(sink, opts.compact);
     }
-    return nfa;
+    sink.flush();
+    phase.stop();
+
+    PhaseScope dotPhase(profile, "dot");
+    OutputSink dotSink(dot);
+    nfa.writeDot(dotSink);
+    dotSink.flush();
+    return sink.bytesWritten() + dotSink.bytesWritten();
 }
 
-NFA kleene_star(NFA& nfa1) {
+// Una sola expresion: escribe la salida y la imagen de graphviz. Con cache,
+// un acierto copia la salida y el DOT guardados sin compilar nada.
+static void compileSingle(const string& regEx, const Options& opts, const string& output_path, CompileCache* cache,
+                          Profile* profile) {
+    string base = output_path.substr(0, output_path.find_last_of('.'));
+    CacheEntry entry;
+    string key = cache ? cacheKey(regEx, opts, false) : string();
+    PhaseScope lookup(cache ? profile : nullptr, "cache");
+    bool hit = cache && cache->lookup(key, entry);
+    lookup.stop();
     NFA nfa;
-    State* start = new State();
-    nfa.addState(start);
-    nfa.makeStart(start);
-    nfa.addTransition(start, nfa1.start, '$');
-    for (auto accept_state : nfa1.accept) {
-        nfa.addTransition(accept_state, nfa1.start, '$');
-        nfa.addTransition(accept_state, start, '$');
-    }
-    nfa.states.insert(nfa.states.end(), nfa1.states.begin(), nfa1.states.end());
-    nfa.makeAccept(start);
-    return nfa;
-}
-
-NFA thompson(const string& regEx) {
-    vector<char> postfix;
-    if (parseRegEx(addConcat(regEx), postfix) == INVALID_REGEX) {
-        throw invalid_argument("Invalid regular expression");
+    DFA dfa;
+    if (!hit) {
+        nfa = compile(regEx, opts, make_shared<StateArena>(), profile, &entry.minStats, &dfa);
     }
-
-    if (postfix.empty()) {
-        NFA nfa;
-        State* start_state = new State();
-        nfa.addState(start_state);
-        nfa.makeStart(start_state);
-        return nfa;
+    if (opts.min) {
+        cout << "Minimized DFA: " << entry.minStats.statesBefore << " -> " << entry.minStats.statesAfter
+             << " states (" << entry.minStats.removed() << " removed)" << endl;
     }
-
-    stack<NFA> stackNFA;
-    for (char symbol : postfix) {
-        if (OPERATORS.find(symbol) == OPERATORS.end()) {
-            stackNFA.push(kleene_base_cases(symbol));
-        } else if (symbol == '+') {
-            NFA N2 = stackNFA.top(); stackNFA.pop();
-            NFA N1 = stackNFA.top(); stackNFA.pop();
-            stackNFA.push(kleene_union(N1, N2));
-        } else if (symbol == '.') {
-            NFA N2 = stackNFA.top(); stackNFA.pop();
-            NFA N1 = stackNFA.top(); stackNFA.pop();
-            stackNFA.push(kleene_concat(N1, N2));
-        } else if (symbol == '*') {
-            NFA N = stackNFA.top(); stackNFA.pop();
-            stackNFA.push(kleene_star(N));
+    if (!cache) {
+        {
+            ofstream out(output_path, ios::binary);
+            ofstream dot(base + ".dot", ios::binary);
+            size_t bytes = serialize(nfa, dfa, opts, out, dot, profile);
+            if (profile) {
+                profile->bytesWritten += bytes;
+            }
         }
+        PhaseScope graphviz(profile, "graphviz");
+        render_dot(base);
+        return;
     }
-
-    if (stackNFA.empty()) {
-        throw invalid_argument("Invalid regular expression");
+    if (!hit) {
+        ostringstream out, dot;
+        serialize(nfa, dfa, opts, out, dot, profile);
+        entry.output = out.str();
+        entry.dot = dot.str();
+        PhaseScope store(profile, "cache");
+        cache->store(key, entry);
     }
-
-    return stackNFA.top();
+    PhaseScope write(profile, "write");
+    writeFile(output_path, entry.output, profile);
+    writeFile(base + ".dot", entry.dot, profile);
+    write.stop();
+    PhaseScope graphviz(profile, "graphviz");
+    render_dot(base);
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        cerr << "Usage: regex-NFA <input_json> <output_json>" << endl;
+    Options opts;
+    vector<string> args;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--dfa") {
+            opts.dfa = true;
+        } else if (arg == "--min") {
+            opts.min = true;
+        } else if (arg == "--no-eps") {
+            opts.noEps = true;
+        } else if (arg == "--compact") {
+            opts.compact = true;
+        } else if (arg == "--binary") {
+            opts.binary = true;
+        } else if (arg == "--stats") {
+            opts.stats = true;
+        } else if (arg == "--counters") {
+            opts.counters = true;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            opts.traceFile = argv[++i];
+        } else if (arg == "--cache" && i + 1 < argc) {
+            opts.cacheDir = argv[++i];
+        } else if (arg == "--cache-size" && i + 1 < argc) {
+            opts.cacheBytes = stoull(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            opts.threads = stoul(argv[++i]);
+        } else {
+            args.push_back(arg);
+        }
+    }
+    if (args.size() != 2) {
+        cerr << "Usage: regex-NFA [--dfa | --min | --no-eps] [--compact | --binary] [--threads N] [--cache DIR [--cache-size BYTES]] [--stats] [--trace FILE] [--counters] <input_json> <output_json>" << endl;
         return 1;
     }
 
-    string regEx = readJSON(argv[1]);
-    if (regEx.empty()) {
-        regEx = "";
+    // --stats: al terminar se imprime en stderr un objeto JSON con el tiempo de
+    // cada fase y los contadores de la corrida. --trace guarda las mismas fases
+    // como traza de Chrome, con un carril por hilo. --counters agrega a cada
+    // fase los contadores de hardware y los imprime como tabla en stderr; si el
+    // sistema no los ofrece, se avisa y la compilacion sigue igual.
+    if (opts.counters && !PerfCounters::forThread().available()) {
+        cerr << "Hardware counters unavailable: " << PerfCounters::forThread().error() << endl;
+        opts.counters = false;
     }
-
-    NFA nfa = thompson(regEx);
-    nfa.getAlph(regEx);
-    nfa.names();
-    string output_path = argv[2];
-    nfa.nfaJson(output_path);
-
-    ifstream file(output_path);
-    json nfa_json;
-    file >> nfa_json;
-    visualize_nfa(nfa_json, output_path.substr(0, output_path.find_last_of('.')));
-
-    return 0;
-}
\ No newline at end of file
+    unique_ptr<Profile> stats;
+    if (opts.stats || opts.counters || !opts.traceFile.empty()) {
+        stats = make_unique<Profile>(!opts.traceFile.empty(), opts.counters);
+        setAllocTracking(opts.stats);
+    }
+    Profile* profile = stats.get();
+    auto start = chrono::steady_clock::now();
+
+    PhaseScope read(profile, "read_input");
+    bool batch = false;
+    vector<string> inputErrors;
+    vector<string> regexes;
+    try {
+        regexes = readRegexes(args[0], &batch, &inputErrors);
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    read.stop();
+    string output_path = args[1];
+    unique_ptr<CompileCache> cache;
+    if (!opts.cacheDir.empty()) {
+        cache = make_unique<CompileCache>(opts.cacheDir, opts.cacheBytes);
+    }
+    int status = 0;
+    if (batch) {
+        if (opts.binary) {
+            cerr << "--binary is not supported with batch input" << endl;
+            return 1;
+        }
+        TraceScope span(profile, "compile_batch");
+        status = compileBatch(regexes, inputErrors, opts, output_path, cache.get(), profile);
+    } else if (!inputErrors[0].empty()) {
+        cerr << inputErrors[0] << endl;
+        return 1;
+    } else {
+        TraceScope span(profile, "compile_single");
+        compileSingle(regexes[0], opts, output_path, cache.get(), profile);
+    }
+    if (cache) {
+        PhaseScope trim(profile, "cache");
+        cache->trim();
+        trim.stop();
+        CacheStats cacheStats = cache->stats();
+        cerr << "Cache: " << cacheStats.hits << " hits, " << cacheStats.misses << " misses, " << cacheStats.evictions
+             << " evicted" << endl;
+    }
+    if (opts.stats) {
+        setAllocTracking(false);
+        AllocCounts allocs = allocCounts();
+        stats->wallMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        stats->allocations = allocs.count;
+        stats->bytesAllocated = allocs.bytes;
+        OutputSink sink(cerr);
+        stats->writeJson(sink);
+    }
+    if (opts.counters) {
+        stats->writeCounters(cerr, PerfCounters::forThread());
+    }
+    if (!opts.traceFile.empty()) {
+        ofstream file(opts.traceFile, ios::binary);
+        if (!file) {
+            cerr << "Cannot open " << opts.traceFile << endl;
+            return 1;
+        }
+        OutputSink sink(file);
+        stats->writeTrace(sink);
+    }
+    return status;
+}
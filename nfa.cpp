@@ -0,0 +1,484 @@
+#include "nfa.hpp"
+#include "pikevm.hpp"
+#include "jsonwriter.hpp"
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <stack>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdio>
+
+using namespace std;
+using json = nlohmann::json;
+
+NFA::NFA() : start(nullptr), arena(make_shared<StateArena>()) {}
+
+NFA::NFA(shared_ptr<StateArena> arena) : start(nullptr), arena(move(arena)) {}
+
+NFA::NFA(const NFA& other)
+    : states(other.states), start(other.start), accept(other.accept), alphabet(other.alphabet),
+      arena(other.arena), flat(other.flat), nameIds(other.nameIds) {}
+
+NFA::NFA(NFA&& other) noexcept = default;
+
+NFA& NFA::operator=(const NFA& other) {
+    NFA copy(other);
+    return *this = move(copy);
+}
+
+NFA& NFA::operator=(NFA&& other) noexcept = default;
+
+NFA::~NFA() = default;
+
+void NFA::getAlph(const string& regex) {
+    for (char c : regex) {
+        if (OPERATORS.find(c) == OPERATORS.end() && alphabet.find(c) == alphabet.end()) {
+            alphabet.insert(c);
+        }
+    }
+}
+
+void NFA::removeAccept(State* s) {
+    accept.erase(remove(accept.begin(), accept.end(), s), accept.end());
+}
+
+void NFA::finalize() {
+    // Ids densos 0..n-1 en el orden de states: las aristas se traducen
+    // leyendo el id del destino, sin tablas auxiliares.
+    for (uint32_t i = 0; i < states.size(); ++i) {
+        states[i]->id = static_cast<int>(i);
+    }
+    flat = FlatNFA();
+    nameIds.clear();
+    vm.reset();
+    flat.offsets.reserve(states.size() + 1);
+    flat.offsets.push_back(0);
+    for (auto state : states) {
+        for (auto& transition : state->transitions) {
+            flat.targets.push_back(static_cast<uint32_t>(transition.first->id));
+            flat.labels.push_back(static_cast<unsigned char>(transition.second));
+        }
+        flat.offsets.push_back(static_cast<uint32_t>(flat.targets.size()));
+    }
+    flat.start = static_cast<uint32_t>(start->id);
+    for (auto state : accept) {
+        flat.accept.push_back(static_cast<uint32_t>(state->id));
+    }
+}
+
+void NFA::names() {
+    uint32_t c = 0;
+    nameIds.assign(flat.size(), UNNAMED);
+    if (flat.size() == 0) {
+        return;
+    }
+    vector<uint32_t> states_queue;
+    states_queue.reserve(flat.size());
+    nameIds[flat.start] = c++;
+    states_queue.push_back(flat.start);
+    for (size_t head = 0; head < states_queue.size(); ++head) {
+        uint32_t cur = states_queue[head];
+        for (uint32_t e = flat.offsets[cur]; e < flat.offsets[cur + 1]; ++e) {
+            uint32_t t = flat.targets[e];
+            if (nameIds[t] == UNNAMED) {
+                nameIds[t] = c++;
+                states_queue.push_back(t);
+            }
+        }
+    }
+}
+
+static void writeStateName(JsonWriter& w, const NFA& nfa, uint32_t s) {
+    uint32_t id = nfa.nameId(s);
+    if (id == NFA::UNNAMED) {
+        w.value(string_view());
+        return;
+    }
+    char buf[16];
+    buf[0] = 'q';
+    auto res = to_chars(buf + 1, buf + sizeof(buf), id);
+    w.value(string_view(buf, res.ptr - buf));
+}
+
+void NFA::writeJson(OutputSink& sink, bool compact) const {
+    JsonWriter w(sink, compact ? 0 : 4);
+    w.beginObject();
+    w.key("final_states");
+    w.beginArray();
+    for (auto i : flat.accept) {
+        writeStateName(w, *this, i);
+    }
+    w.endArray();
+    w.key("letters");
+    w.beginArray();
+    for (char c : alphabet) {
+        w.value(string_view(&c, 1));
+    }
+    w.endArray();
+    w.key("start_states");
+    w.beginArray();
+    if (flat.size() > 0) {
+        writeStateName(w, *this, flat.start);
+    }
+    w.endArray();
+    w.key("states");
+    w.beginArray();
+    for (uint32_t i = 0; i < flat.size(); ++i) {
+        writeStateName(w, *this, i);
+    }
+    w.endArray();
+    w.key("transition_function");
+    w.beginArray();
+    for (uint32_t i = 0; i < flat.size(); ++i) {
+        for (uint32_t e = flat.offsets[i]; e < flat.offsets[i + 1]; ++e) {
+            char label = static_cast<char>(flat.labels[e]);
+            w.beginArray();
+            writeStateName(w, *this, i);
+            w.value(string_view(&label, 1));
+            writeStateName(w, *this, flat.targets[e]);
+            w.endArray();
+        }
+    }
+    w.endArray();
+    w.endObject();
+    sink.put('\n');
+}
+
+void NFA::nfaJson(const string& path, bool compact) const {
+    ofstream file(path, ios::binary);
+    OutputSink sink(file);
+    writeJson(sink, compact);
+}
+
+bool NFA::match(string_view input) {
+    if (!vm) {
+        vm = make_unique<PikeVM>(flat);
+    }
+    return vm->match(input);
+}
+
+bool NFA::search(string_view input, MatchSpan* span) {
+    if (!vm) {
+        vm = make_unique<PikeVM>(flat);
+    }
+    return vm->search(input, span);
+}
+
+string addConcat(const string& regEx) {
+    string res;
+    for (size_t i = 0; i < regEx.size(); ++i) {
+        res.push_back(regEx[i]);
+        if (regEx[i] != '(' && regEx[i] != '.' && regEx[i] != '+') {
+            if (i + 1 < regEx.size() && regEx[i + 1] != ')' && regEx[i + 1] != '*' && regEx[i + 1] != '+' && regEx[i + 1] != '.') {
+                res.push_back('.');
+            }
+        }
+    }
+    return res;
+}
+
+int parseRegEx(const string& regEx, vector<char>& postfix) {
+    if (regEx.empty()) return VALID_REGEX;
+
+    for (char a : regEx) {
+        if (ALPHABET.find(a) == string::npos) {
+            return INVALID_REGEX;
+        }
+    }
+
+    postfix.clear();
+    stack<char> stack;
+    for (char a : regEx) {
+        if (OPERATORS.find(a) == OPERATORS.end()) {
+            postfix.push_back(a);
+        } else if (a == '(') {
+            stack.push('(');
+        } else if (a == ')') {
+            while (!stack.empty() && stack.top() != '(') {
+                postfix.push_back(stack.top());
+                stack.pop();
+            }
+            // ')' sin su '(': no se puede seguir desapilando.
+            if (stack.empty()) {
+                return INVALID_REGEX;
+            }
+            stack.pop();
+        } else {
+            while (!stack.empty() && stack.top() != '(' && PRIORITY.at(a) <= PRIORITY.at(stack.top())) {
+                postfix.push_back(stack.top());
+                stack.pop();
+            }
+            stack.push(a);
+        }
+    }
+    while (!stack.empty()) {
+        postfix.push_back(stack.top());
+        stack.pop();
+    }
+    return VALID_REGEX;
+}
+
+static const char* const BAD_ENTRY = "Entry must be a string or an object with a string \"regex\"";
+
+// Expresion de una entrada; false si la entrada no tiene la forma esperada.
+static bool regexOf(const json& entry, string& regEx) {
+    if (entry.is_string()) {
+        regEx = entry.get<string>();
+        return true;
+    }
+    if (!entry.is_object()) {
+        return false;
+    }
+    auto it = entry.find("regex");
+    if (it == entry.end()) {
+        regEx.clear();
+        return true;
+    }
+    if (!it->is_string()) {
+        return false;
+    }
+    regEx = it->get<string>();
+    return true;
+}
+
+static bool endsWith(const string& s, const string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+vector<string> readRegexes(const string& path, bool* batch, vector<string>* errors) {
+    ifstream file(path);
+    if (!file) {
+        throw runtime_error("Cannot open " + path);
+    }
+    stringstream buffer;
+    buffer << file.rdbuf();
+    string text = buffer.str();
+    vector<string> res;
+    vector<string> failed;
+    bool list = true;
+    auto add = [&](const json& entry, const char* error) {
+        string regEx;
+        if (!error && !regexOf(entry, regEx)) {
+            error = BAD_ENTRY;
+        }
+        res.push_back(move(regEx));
+        failed.push_back(error ? error : "");
+    };
+
+    json data = json::parse(text, nullptr, false);
+    if (!endsWith(path, ".ndjson") && !endsWith(path, ".jsonl") && !data.is_discarded()) {
+        if (data.is_array()) {
+            for (const auto& entry : data) {
+                add(entry, nullptr);
+            }
+        } else if (data.is_object() && data.contains("regex") && data["regex"].is_array()) {
+            for (const auto& entry : data["regex"]) {
+                add(entry, nullptr);
+            }
+        } else {
+            add(data, nullptr);
+            list = false;
+        }
+    } else {
+        istringstream lines(text);
+        string line;
+        while (getline(lines, line)) {
+            if (line.find_first_not_of(" \t\r") != string::npos) {
+                json entry = json::parse(line, nullptr, false);
+                add(entry, entry.is_discarded() ? "Entry is not valid JSON" : nullptr);
+            }
+        }
+    }
+    if (res.empty()) {
+        throw invalid_argument("No regular expressions in " + path);
+    }
+    if (batch) {
+        *batch = list;
+    }
+    // Sin errors, una entrada invalida no se puede informar por separado.
+    for (size_t i = 0; i < failed.size() && !errors; ++i) {
+        if (!failed[i].empty()) {
+            throw invalid_argument(list ? "Entry " + to_string(i) + ": " + failed[i] : failed[i]);
+        }
+    }
+    if (errors) {
+        *errors = move(failed);
+    }
+    return res;
+}
+
+void NFA::writeDot(OutputSink& sink) const {
+    vector<char> isAccept(flat.size(), 0);
+    for (auto i : flat.accept) {
+        isAccept[i] = 1;
+    }
+    auto name = [&](uint32_t s) {
+        sink.put('"');
+        uint32_t id = nameId(s);
+        if (id != UNNAMED) {
+            char buf[16];
+            buf[0] = 'q';
+            auto res = to_chars(buf + 1, buf + sizeof(buf), id);
+            sink.write(string_view(buf, res.ptr - buf));
+        }
+        sink.put('"');
+    };
+
+    sink.write("digraph NFA {\n");
+    for (uint32_t i = 0; i < flat.size(); ++i) {
+        sink.write("    ");
+        name(i);
+        if (isAccept[i]) {
+            sink.write(" [shape=doublecircle]");
+        }
+        sink.write(";\n");
+    }
+    for (uint32_t i = 0; i < flat.size(); ++i) {
+        for (uint32_t e = flat.offsets[i]; e < flat.offsets[i + 1]; ++e) {
+            sink.write("    ");
+            name(i);
+            sink.write(" -> ");
+            name(flat.targets[e]);
+            sink.write(" [label=\"");
+            if (flat.labels[e] == '$') {
+                sink.write("ε");
+            } else {
+                sink.put(static_cast<char>(flat.labels[e]));
+            }
+            sink.write("\"];\n");
+        }
+    }
+    if (flat.size() > 0) {
+        sink.write("    start [shape=point];\n");
+        sink.write("    start -> ");
+        name(flat.start);
+        sink.write(";\n");
+    }
+    sink.write("}\n");
+}
+
+void visualize_nfa(const NFA& nfa, const string& output_path) {
+    {
+        ofstream dot(output_path + ".dot", ios::binary);
+        OutputSink sink(dot);
+        nfa.writeDot(sink);
+    }
+    render_dot(output_path);
+}
+
+void render_dot(const string& output_path) {
+    string cmd = "dot -Tpng " + output_path + ".dot -o " + output_path + ".png";
+    system(cmd.c_str());
+    remove((output_path + ".dot").c_str());
+}
+
+Fragment kleene_base_cases(char symbol, StateArena& arena) {
+    Fragment f;
+    f.start = arena.create();
+    if (symbol == '$') {
+        f.addAccept(f.start);
+    } else if (symbol != '\0' && symbol != ' ') {
+        State* q1 = arena.create();
+        f.start->addTransition(q1, symbol);
+        f.addAccept(q1);
+    }
+    return f;
+}
+
+Fragment kleene_union(Fragment&& f1, Fragment&& f2, StateArena& arena) {
+    State* start = arena.create();
+    start->addTransition(f1.start, '$');
+    start->addTransition(f2.start, '$');
+    Fragment f;
+    f.start = start;
+    f.appendAccept(f1);
+    f.appendAccept(f2);
+    return f;
+}
+
+Fragment kleene_concat(Fragment&& f1, Fragment&& f2) {
+    for (State* accept_state = f1.acceptHead; accept_state; accept_state = accept_state->nextAccept) {
+        accept_state->addTransition(f2.start, '$');
+    }
+    Fragment f;
+    f.start = f1.start;
+    f.appendAccept(f2);
+    return f;
+}
+
+Fragment kleene_star(Fragment&& f1, StateArena& arena) {
+    State* start = arena.create();
+    start->addTransition(f1.start, '$');
+    for (State* accept_state = f1.acceptHead; accept_state; accept_state = accept_state->nextAccept) {
+        accept_state->addTransition(f1.start, '$');
+        accept_state->addTransition(start, '$');
+    }
+    Fragment f;
+    f.start = start;
+    f.addAccept(start);
+    return f;
+}
+
+NFA thompson(const string& regEx) {
+    return thompson(regEx, make_shared<StateArena>());
+}
+
+NFA thompson(const string& regEx, const shared_ptr<StateArena>& arena) {
+    vector<char> postfix;
+    if (parseRegEx(addConcat(regEx), postfix) == INVALID_REGEX) {
+        throw invalid_argument("Invalid regular expression");
+    }
+    return thompson(postfix, arena);
+}
+
+NFA thompson(const vector<char>& postfix, const shared_ptr<StateArena>& arena) {
+    size_t first = arena->size();
+    Fragment result;
+    if (postfix.empty()) {
+        result.start = arena->create();
+    } else {
+        vector<Fragment> stackNFA;
+        for (char symbol : postfix) {
+            size_t operands = (symbol == '+' || symbol == '.') ? 2 : (symbol == '*') ? 1 : 0;
+            // Un parentesis sin pareja queda en la postfija; como antes, se ignora.
+            if (operands == 0 && OPERATORS.find(symbol) != OPERATORS.end()) {
+                continue;
+            }
+            if (stackNFA.size() < operands) {
+                throw invalid_argument("Invalid regular expression");
+            }
+            if (operands == 0) {
+                stackNFA.push_back(kleene_base_cases(symbol, *arena));
+            } else if (operands == 2) {
+                Fragment N2 = move(stackNFA.back()); stackNFA.pop_back();
+                Fragment N1 = move(stackNFA.back()); stackNFA.pop_back();
+                if (symbol == '+') {
+                    stackNFA.push_back(kleene_union(move(N1), move(N2), *arena));
+                } else {
+                    stackNFA.push_back(kleene_concat(move(N1), move(N2)));
+                }
+            } else {
+                Fragment N = move(stackNFA.back()); stackNFA.pop_back();
+                stackNFA.push_back(kleene_star(move(N), *arena));
+            }
+        }
+        if (stackNFA.empty()) {
+            throw invalid_argument("Invalid regular expression");
+        }
+        result = move(stackNFA.back());
+    }
+
+    NFA nfa(arena);
+    nfa.states.reserve(arena->size() - first);
+    for (size_t i = first; i < arena->size(); ++i) {
+        nfa.addState((*arena)[i]);
+    }
+    nfa.makeStart(result.start);
+    for (State* s = result.acceptHead; s; s = s->nextAccept) {
+        nfa.accept.push_back(s);
+    }
+    nfa.finalize();
+    return nfa;
+}
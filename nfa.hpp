@@ -0,0 +1,243 @@
+#ifndef REGEX_NFA_NFA_HPP
+#define REGEX_NFA_NFA_HPP
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <cstdint>
+#include "json.hpp"
+
+const std::string ALPHABET = "0123456789abcdefghijklmnopqrstuvwxyz*.+()$";
+const std::unordered_set<char> OPERATORS = {'*', '.', '+', '(', ')'};
+const std::unordered_map<char, int> PRIORITY = {{'*', 2}, {'.', 1}, {'+', 0}};
+const int INVALID_REGEX = -1;
+const int VALID_REGEX = 0;
+
+class PikeVM;
+struct MatchSpan;
+class OutputSink;
+
+class State {
+public:
+    // Indice denso del estado dentro de su NFA (0..n-1, reasignado por
+    // finalize()); no hay contador global, asi que es seguro entre hilos.
+    int id;
+    std::vector<std::pair<State*, char>> transitions;
+    // Siguiente estado de aceptacion del Fragment en construccion.
+    State* nextAccept = nullptr;
+
+    explicit State(int id) : id(id) {}
+
+    void addTransition(State* node, char alph) {
+        transitions.push_back({node, alph});
+    }
+};
+
+// Reserva los estados por bloques contiguos y los libera todos juntos al destruirse.
+// reset() destruye los estados pero conserva los bloques para reutilizarlos.
+class StateArena {
+public:
+    static const size_t BLOCK_SIZE = 256;
+
+    StateArena() : active(0), used(BLOCK_SIZE), count(0) {}
+    StateArena(const StateArena&) = delete;
+    StateArena& operator=(const StateArena&) = delete;
+
+    ~StateArena() {
+        release();
+    }
+
+    State* create() {
+        if (used == BLOCK_SIZE) {
+            if (active == blocks.size()) {
+                blocks.push_back(static_cast<State*>(::operator new(sizeof(State) * BLOCK_SIZE)));
+            }
+            active++;
+            used = 0;
+        }
+        State* s = new (blocks[active - 1] + used) State(static_cast<int>(count));
+        used++;
+        count++;
+        return s;
+    }
+
+    void reset() {
+        for (size_t i = 0; i < count; ++i) {
+            (*this)[i]->~State();
+        }
+        active = 0;
+        used = BLOCK_SIZE;
+        count = 0;
+    }
+
+    void release() {
+        reset();
+        for (auto block : blocks) {
+            ::operator delete(block);
+        }
+        blocks.clear();
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    // Estados en orden de creacion.
+    State* operator[](size_t i) const {
+        return blocks[i / BLOCK_SIZE] + i % BLOCK_SIZE;
+    }
+
+private:
+    std::vector<State*> blocks;
+    size_t active;
+    size_t used;
+    size_t count;
+};
+
+// Tabla de transiciones compacta (CSR): las aristas del estado i ocupan
+// targets/labels[offsets[i] .. offsets[i + 1]).
+struct FlatNFA {
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> targets;
+    std::vector<unsigned char> labels;
+    uint32_t start = 0;
+    std::vector<uint32_t> accept;
+
+    size_t size() const {
+        return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+};
+
+class NFA {
+public:
+    std::vector<State*> states;
+    State* start;
+    std::vector<State*> accept;
+    std::unordered_set<char> alphabet;
+    std::shared_ptr<StateArena> arena;
+    FlatNFA flat;
+    // Numero asignado por names() a cada estado de la tabla plana (UNNAMED si
+    // no es alcanzable); el nombre "q<n>" se genera al serializar. finalize()
+    // lo vacia: hasta llamar a names() conviene leerlo con nameId().
+    std::vector<uint32_t> nameIds;
+    static constexpr uint32_t UNNAMED = UINT32_MAX;
+
+    NFA();
+    explicit NFA(std::shared_ptr<StateArena> arena);
+    // Las copias no comparten la PikeVM de match()/search(): tiene memoria de
+    // trabajo propia y cada copia puede usarse desde otro hilo.
+    NFA(const NFA& other);
+    NFA(NFA&& other) noexcept;
+    NFA& operator=(const NFA& other);
+    NFA& operator=(NFA&& other) noexcept;
+    ~NFA();
+
+    State* newState() {
+        State* s = arena->create();
+        addState(s);
+        return s;
+    }
+
+    void getAlph(const std::string& regex);
+
+    void addState(State* s) {
+        states.push_back(s);
+    }
+
+    void addTransition(State* s1, State* s2, char a) {
+        s1->addTransition(s2, a);
+    }
+
+    void makeStart(State* s) {
+        start = s;
+    }
+
+    void makeAccept(State* s) {
+        accept.push_back(s);
+    }
+
+    void removeAccept(State* s);
+    void finalize();
+    void names();
+    // UNNAMED tambien si names() no se llamo despues del ultimo finalize().
+    uint32_t nameId(uint32_t s) const {
+        return s < nameIds.size() ? nameIds[s] : UNNAMED;
+    }
+    // Escribe el automata en JSON en una sola pasada; compact omite la indentacion.
+    void nfaJson(const std::string& path, bool compact = false) const;
+    void writeJson(OutputSink& sink, bool compact = false) const;
+    // Descripcion en formato DOT de graphviz, con los mismos nombres que nfaJson.
+    void writeDot(OutputSink& sink) const;
+
+    // Simulan el automata sobre la tabla plana; requieren finalize().
+    bool match(std::string_view input);
+    bool search(std::string_view input, MatchSpan* span = nullptr);
+
+private:
+    std::unique_ptr<PikeVM> vm;
+};
+
+std::string addConcat(const std::string& regEx);
+int parseRegEx(const std::string& regEx, std::vector<char>& postfix);
+// Lee una o varias expresiones: {"regex": "..."}, {"regex": [...]}, un arreglo
+// de cadenas u objetos, o NDJSON (una entrada por linea; siempre si el archivo
+// termina en .ndjson o .jsonl). batch indica si la entrada era una lista.
+// Si se pasa errors, recibe un mensaje por entrada (vacio si es valida) y las
+// entradas invalidas se devuelven como ""; si no, lanzan invalid_argument.
+// Lanza runtime_error si no se puede abrir el archivo e invalid_argument si no
+// tiene ninguna entrada.
+std::vector<std::string> readRegexes(const std::string& path, bool* batch = nullptr,
+                                     std::vector<std::string>* errors = nullptr);
+// Genera output_path.png con graphviz a partir del automata en memoria.
+void visualize_nfa(const NFA& nfa, const std::string& output_path);
+// Genera output_path.png a partir de output_path.dot, que luego se borra.
+void render_dot(const std::string& output_path);
+
+// Subautomata en construccion: sus estados viven en la arena compartida, asi
+// que solo se guardan el estado inicial y los de aceptacion. Estos forman una
+// lista enlazada a traves de State::nextAccept, de modo que crear una hoja o
+// unir dos listas no reserva memoria.
+struct Fragment {
+    State* start = nullptr;
+    State* acceptHead = nullptr;
+    State* acceptTail = nullptr;
+
+    void addAccept(State* s) {
+        s->nextAccept = nullptr;
+        if (acceptTail) {
+            acceptTail->nextAccept = s;
+        } else {
+            acceptHead = s;
+        }
+        acceptTail = s;
+    }
+
+    // Agrega al final los estados de aceptacion de other, conservando el orden.
+    void appendAccept(const Fragment& other) {
+        if (!other.acceptHead) {
+            return;
+        }
+        if (acceptTail) {
+            acceptTail->nextAccept = other.acceptHead;
+        } else {
+            acceptHead = other.acceptHead;
+        }
+        acceptTail = other.acceptTail;
+    }
+};
+
+Fragment kleene_base_cases(char symbol, StateArena& arena);
+Fragment kleene_union(Fragment&& f1, Fragment&& f2, StateArena& arena);
+Fragment kleene_concat(Fragment&& f1, Fragment&& f2);
+Fragment kleene_star(Fragment&& f1, StateArena& arena);
+NFA thompson(const std::string& regEx);
+// Igual que la anterior, pero crea los estados en una arena provista por el
+// llamador (por ejemplo, para reutilizar sus bloques entre expresiones).
+NFA thompson(const std::string& regEx, const std::shared_ptr<StateArena>& arena);
+// Construye a partir de la forma postfija ya calculada por parseRegEx.
+NFA thompson(const std::vector<char>& postfix, const std::shared_ptr<StateArena>& arena);
+
+#endif
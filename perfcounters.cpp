@@ -0,0 +1,103 @@
+#include "perfcounters.hpp"
+#include <cerrno>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef __linux__
+static const uint64_t EVENTS[PERF_COUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+PerfCounters::PerfCounters() {
+    for (int c = 0; c < PERF_COUNTERS; ++c) {
+        fds[c] = -1;
+        slot[c] = -1;
+    }
+    for (int c = 0; c < PERF_COUNTERS; ++c) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = EVENTS[c];
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // El primero que se abre es el lider; los demas se suman a su grupo.
+        int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+        if (fd < 0) {
+            if (reason.empty()) {
+                reason = string(name(static_cast<PerfCounter>(c))) + ": " + strerror(errno);
+                if (errno == EACCES || errno == EPERM) {
+                    reason += " (see /proc/sys/kernel/perf_event_paranoid)";
+                }
+            }
+            continue;
+        }
+        if (leader < 0) {
+            leader = fd;
+        }
+        fds[c] = fd;
+        slot[c] = opened++;
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (int fd : fds) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+CounterValues PerfCounters::read() const {
+    CounterValues result;
+    if (leader < 0) {
+        return result;
+    }
+    // nr, tiempo habilitado, tiempo corriendo y un valor por contador.
+    uint64_t buf[3 + PERF_COUNTERS];
+    ssize_t n = ::read(leader, buf, sizeof(buf));
+    if (n < static_cast<ssize_t>(3 * sizeof(uint64_t))) {
+        return result;
+    }
+    double scale = buf[2] > 0 && buf[2] < buf[1] ? static_cast<double>(buf[1]) / buf[2] : 1.0;
+    for (int c = 0; c < PERF_COUNTERS; ++c) {
+        if (slot[c] >= 0 && static_cast<uint64_t>(slot[c]) < buf[0]) {
+            result.value[c] = static_cast<uint64_t>(buf[3 + slot[c]] * scale);
+        }
+    }
+    return result;
+}
+#else
+PerfCounters::PerfCounters() : reason("perf_event_open is only available on Linux") {
+    for (int c = 0; c < PERF_COUNTERS; ++c) {
+        fds[c] = -1;
+        slot[c] = -1;
+    }
+}
+
+PerfCounters::~PerfCounters() {}
+
+CounterValues PerfCounters::read() const {
+    return CounterValues();
+}
+#endif
+
+PerfCounters& PerfCounters::forThread() {
+    thread_local PerfCounters counters;
+    return counters;
+}
+
+const char* PerfCounters::name(PerfCounter c) {
+    static const char* const NAMES[PERF_COUNTERS] = {"cycles", "instructions", "cache-misses", "branch-misses"};
+    return NAMES[c];
+}
@@ -0,0 +1,66 @@
+#ifndef REGEX_NFA_PERFCOUNTERS_HPP
+#define REGEX_NFA_PERFCOUNTERS_HPP
+
+#include <string>
+#include <cstdint>
+
+enum PerfCounter { PERF_CYCLES, PERF_INSTRUCTIONS, PERF_CACHE_MISSES, PERF_BRANCH_MISSES, PERF_COUNTERS };
+
+struct CounterValues {
+    uint64_t value[PERF_COUNTERS] = {};
+
+    CounterValues& operator+=(const CounterValues& other) {
+        for (int c = 0; c < PERF_COUNTERS; ++c) {
+            value[c] += other.value[c];
+        }
+        return *this;
+    }
+
+    CounterValues operator-(const CounterValues& other) const {
+        CounterValues diff;
+        for (int c = 0; c < PERF_COUNTERS; ++c) {
+            diff.value[c] = value[c] >= other.value[c] ? value[c] - other.value[c] : 0;
+        }
+        return diff;
+    }
+};
+
+// Contadores de hardware del hilo que crea el objeto, en modo usuario, leidos
+// con perf_event_open como un solo grupo. Solo existen en Linux; si el sistema
+// no los ofrece (otro sistema operativo, perf_event_paranoid, contenedores o
+// maquinas virtuales sin PMU) available() es falso, error() dice por que y
+// read() devuelve ceros. Cada contador puede faltar por separado.
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const {
+        return leader >= 0;
+    }
+    bool available(PerfCounter c) const {
+        return slot[c] >= 0;
+    }
+    const std::string& error() const {
+        return reason;
+    }
+
+    // Valores acumulados desde la creacion. Si el kernel multiplexa el grupo,
+    // se escalan por la fraccion de tiempo que estuvo activo.
+    CounterValues read() const;
+
+    // Los contadores del hilo actual, abiertos la primera vez que se piden.
+    static PerfCounters& forThread();
+    static const char* name(PerfCounter c);
+
+private:
+    int fds[PERF_COUNTERS];
+    int slot[PERF_COUNTERS];  // posicion en la lectura del grupo, o -1
+    int leader = -1;
+    int opened = 0;
+    std::string reason;
+};
+
+#endif
@@ -0,0 +1,152 @@
+#include "pikevm.hpp"
+#include <utility>
+
+using namespace std;
+
+void epsilonClosureLists(const FlatNFA& flat, vector<uint32_t>& offsets, vector<uint32_t>& states) {
+    size_t n = flat.size();
+    vector<char> important(n, 0);
+    for (auto s : flat.accept) {
+        important[s] = 1;
+    }
+    for (size_t s = 0; s < n; ++s) {
+        for (uint32_t e = flat.offsets[s]; e < flat.offsets[s + 1]; ++e) {
+            if (flat.labels[e] != '$') {
+                important[s] = 1;
+            }
+        }
+    }
+
+    offsets.clear();
+    states.clear();
+    vector<uint32_t> seen(n, UINT32_MAX);
+    vector<uint32_t> work;
+    offsets.reserve(n + 1);
+    offsets.push_back(0);
+    for (uint32_t s = 0; s < n; ++s) {
+        work.push_back(s);
+        seen[s] = s;
+        while (!work.empty()) {
+            uint32_t cur = work.back();
+            work.pop_back();
+            if (important[cur]) {
+                states.push_back(cur);
+            }
+            for (uint32_t e = flat.offsets[cur]; e < flat.offsets[cur + 1]; ++e) {
+                uint32_t t = flat.targets[e];
+                if (flat.labels[e] == '$' && seen[t] != s) {
+                    seen[t] = s;
+                    work.push_back(t);
+                }
+            }
+        }
+        offsets.push_back(static_cast<uint32_t>(states.size()));
+    }
+}
+
+PikeVM::PikeVM(const FlatNFA& flat)
+    : flat(flat), isAccept(flat.size(), 0), clist(flat.size()), nlist(flat.size()),
+      cstart(flat.size()), nstart(flat.size()) {
+    for (auto s : flat.accept) {
+        isAccept[s] = 1;
+    }
+    epsilonClosureLists(flat, closureOffsets, closureStates);
+}
+
+void PikeVM::addClosure(SparseSet& set, vector<size_t>& starts, uint32_t s, size_t begin) {
+    for (uint32_t i = closureOffsets[s]; i < closureOffsets[s + 1]; ++i) {
+        uint32_t t = closureStates[i];
+        if (!set.contains(t)) {
+            starts[set.insert(t)] = begin;
+        }
+    }
+}
+
+bool PikeVM::match(string_view input) {
+    if (flat.size() == 0) {
+        return false;
+    }
+    clist.clear();
+    addClosure(clist, cstart, flat.start, 0);
+    for (char ch : input) {
+        unsigned char c = static_cast<unsigned char>(ch);
+        nlist.clear();
+        for (size_t k = 0; k < clist.size(); ++k) {
+            uint32_t s = clist[k];
+            for (uint32_t e = flat.offsets[s]; e < flat.offsets[s + 1]; ++e) {
+                if (flat.labels[e] == c && c != '$') {
+                    addClosure(nlist, nstart, flat.targets[e], 0);
+                }
+            }
+        }
+        swap(clist, nlist);
+        swap(cstart, nstart);
+        if (clist.size() == 0) {
+            return false;
+        }
+    }
+    for (size_t k = 0; k < clist.size(); ++k) {
+        if (isAccept[clist[k]]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PikeVM::search(string_view input, MatchSpan* span) {
+    if (flat.size() == 0) {
+        return false;
+    }
+    // Los hilos quedan ordenados por posicion de inicio, asi que al insertar un
+    // estado repetido se conserva siempre el inicio mas a la izquierda.
+    bool found = false;
+    size_t bestBegin = 0, bestEnd = 0;
+    clist.clear();
+    for (size_t i = 0;; ++i) {
+        if (!found) {
+            addClosure(clist, cstart, flat.start, i);
+        }
+        for (size_t k = 0; k < clist.size(); ++k) {
+            if (!isAccept[clist[k]]) {
+                continue;
+            }
+            if (!span) {
+                return true;
+            }
+            if (!found || cstart[k] < bestBegin) {
+                found = true;
+                bestBegin = cstart[k];
+                bestEnd = i;
+            } else if (cstart[k] == bestBegin) {
+                bestEnd = i;
+            }
+        }
+        if (i == input.size()) {
+            break;
+        }
+
+        unsigned char c = static_cast<unsigned char>(input[i]);
+        nlist.clear();
+        for (size_t k = 0; k < clist.size(); ++k) {
+            if (found && cstart[k] > bestBegin) {
+                continue;
+            }
+            uint32_t s = clist[k];
+            for (uint32_t e = flat.offsets[s]; e < flat.offsets[s + 1]; ++e) {
+                if (flat.labels[e] == c && c != '$') {
+                    addClosure(nlist, nstart, flat.targets[e], cstart[k]);
+                }
+            }
+        }
+        swap(clist, nlist);
+        swap(cstart, nstart);
+        if (found && clist.size() == 0) {
+            break;
+        }
+    }
+    if (found && span) {
+        span->begin = bestBegin;
+        span->end = bestEnd;
+    }
+    return found;
+}
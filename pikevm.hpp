@@ -0,0 +1,77 @@
+#ifndef REGEX_NFA_PIKEVM_HPP
+#define REGEX_NFA_PIKEVM_HPP
+
+#include <vector>
+#include <string_view>
+#include <cstdint>
+#include "nfa.hpp"
+
+struct MatchSpan {
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+// Conjunto disperso de ids en [0, n): insercion, pertenencia y vaciado en O(1).
+class SparseSet {
+public:
+    explicit SparseSet(size_t n = 0) : dense(n), sparse(n), count(0) {}
+
+    bool contains(uint32_t x) const {
+        uint32_t i = sparse[x];
+        return i < count && dense[i] == x;
+    }
+
+    // Devuelve la posicion de x en el orden de insercion.
+    uint32_t insert(uint32_t x) {
+        sparse[x] = count;
+        dense[count] = x;
+        return count++;
+    }
+
+    void clear() {
+        count = 0;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    uint32_t operator[](size_t i) const {
+        return dense[i];
+    }
+
+private:
+    std::vector<uint32_t> dense;
+    std::vector<uint32_t> sparse;
+    uint32_t count;
+};
+
+// Calcula la clausura epsilon de cada estado como lista de ids, restringida a
+// estados que consumen simbolos o que son de aceptacion.
+void epsilonClosureLists(const FlatNFA& flat, std::vector<uint32_t>& offsets, std::vector<uint32_t>& states);
+
+// Simulacion de Thompson/Pike sobre la tabla plana: mantiene el conjunto de
+// estados activos en dos SparseSet y expande las clausuras epsilon
+// precalculadas, por lo que el costo es lineal en la longitud de la entrada.
+// Guarda memoria de trabajo propia: usar una instancia por hilo.
+class PikeVM {
+public:
+    explicit PikeVM(const FlatNFA& flat);
+
+    // La entrada completa debe pertenecer al lenguaje.
+    bool match(std::string_view input);
+    // Busca la subcadena aceptada mas a la izquierda (y la mas larga entre ellas).
+    bool search(std::string_view input, MatchSpan* span = nullptr);
+
+private:
+    FlatNFA flat;
+    std::vector<char> isAccept;
+    std::vector<uint32_t> closureOffsets;
+    std::vector<uint32_t> closureStates;
+    SparseSet clist, nlist;
+    std::vector<size_t> cstart, nstart;
+
+    void addClosure(SparseSet& set, std::vector<size_t>& starts, uint32_t s, size_t begin);
+};
+
+#endif
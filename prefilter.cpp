@@ -0,0 +1,172 @@
+#include "prefilter.hpp"
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+// Los literales se recortan a este largo: un prefijo o una subcadena de un
+// literal obligatorio siguen siendo obligatorios, y se evita que una cadena de
+// concatenaciones copie textos cada vez mas largos.
+static const size_t MAX_LITERAL = 64;
+
+namespace {
+
+// Resumen de una subexpresion. Si exact, su lenguaje es exactamente {word}.
+struct LiteralInfo {
+    bool exact = false;
+    string word;
+    string prefix;
+    string suffix;
+    string required;
+};
+
+const string& longest(const string& a, const string& b) {
+    return b.size() > a.size() ? b : a;
+}
+
+string clipFront(string s) {
+    if (s.size() > MAX_LITERAL) {
+        s.resize(MAX_LITERAL);
+    }
+    return s;
+}
+
+string clipBack(string s) {
+    if (s.size() > MAX_LITERAL) {
+        s.erase(0, s.size() - MAX_LITERAL);
+    }
+    return s;
+}
+
+LiteralInfo symbolInfo(char c) {
+    LiteralInfo info;
+    info.exact = true;
+    if (c != '$') {
+        info.word = info.prefix = info.suffix = info.required = string(1, c);
+    }
+    return info;
+}
+
+LiteralInfo concatInfo(const LiteralInfo& a, const LiteralInfo& b) {
+    LiteralInfo info;
+    info.exact = a.exact && b.exact && a.word.size() + b.word.size() <= MAX_LITERAL;
+    if (info.exact) {
+        info.word = a.word + b.word;
+    }
+    info.prefix = a.exact ? clipFront(a.word + b.prefix) : a.prefix;
+    info.suffix = b.exact ? clipBack(a.suffix + b.word) : b.suffix;
+    info.required = longest(longest(a.required, b.required), clipFront(a.suffix + b.prefix));
+    info.required = longest(info.required, longest(info.prefix, info.suffix));
+    return info;
+}
+
+LiteralInfo unionInfo(const LiteralInfo& a, const LiteralInfo& b) {
+    if (a.exact && b.exact && a.word == b.word) {
+        return a;
+    }
+    LiteralInfo info;
+    size_t p = 0;
+    while (p < a.prefix.size() && p < b.prefix.size() && a.prefix[p] == b.prefix[p]) {
+        p++;
+    }
+    size_t s = 0;
+    while (s < a.suffix.size() && s < b.suffix.size() &&
+           a.suffix[a.suffix.size() - 1 - s] == b.suffix[b.suffix.size() - 1 - s]) {
+        s++;
+    }
+    info.prefix = a.prefix.substr(0, p);
+    info.suffix = a.suffix.substr(a.suffix.size() - s);
+    info.required = longest(info.prefix, info.suffix);
+    if (a.required == b.required) {
+        info.required = longest(info.required, a.required);
+    }
+    return info;
+}
+
+LiteralInfo starInfo(const LiteralInfo& a) {
+    LiteralInfo info;
+    info.exact = a.exact && a.word.empty();
+    return info;
+}
+
+}  // namespace
+
+Literals extractLiterals(const vector<char>& postfix) {
+    vector<LiteralInfo> stack;
+    for (char symbol : postfix) {
+        size_t operands = (symbol == '+' || symbol == '.') ? 2 : (symbol == '*') ? 1 : 0;
+        // Igual que thompson(): los parentesis sin pareja no son literales.
+        if (operands == 0 && OPERATORS.find(symbol) != OPERATORS.end()) {
+            continue;
+        }
+        if (stack.size() < operands) {
+            throw invalid_argument("Invalid regular expression");
+        }
+        if (operands == 0) {
+            stack.push_back(symbolInfo(symbol));
+        } else if (operands == 2) {
+            LiteralInfo b = move(stack.back()); stack.pop_back();
+            LiteralInfo a = move(stack.back()); stack.pop_back();
+            stack.push_back(symbol == '+' ? unionInfo(a, b) : concatInfo(a, b));
+        } else {
+            stack.back() = starInfo(stack.back());
+        }
+    }
+    Literals lits;
+    if (!stack.empty()) {
+        lits.prefix = stack.back().prefix;
+        lits.required = stack.back().required;
+    }
+    return lits;
+}
+
+Literals extractLiterals(const string& regEx) {
+    vector<char> postfix;
+    if (parseRegEx(addConcat(regEx), postfix) == INVALID_REGEX) {
+        throw invalid_argument("Invalid regular expression");
+    }
+    return extractLiterals(postfix);
+}
+
+size_t findLiteral(string_view hay, string_view needle, size_t from) {
+    if (needle.empty()) {
+        return from <= hay.size() ? from : string_view::npos;
+    }
+    while (from + needle.size() <= hay.size()) {
+        const void* hit = memchr(hay.data() + from, needle[0], hay.size() - needle.size() + 1 - from);
+        if (!hit) {
+            break;
+        }
+        size_t pos = static_cast<const char*>(hit) - hay.data();
+        if (memcmp(hay.data() + pos + 1, needle.data() + 1, needle.size() - 1) == 0) {
+            return pos;
+        }
+        from = pos + 1;
+    }
+    return string_view::npos;
+}
+
+PrefilteredSearch::PrefilteredSearch(const FlatNFA& flat, Literals literals) : lits(move(literals)), vm(flat) {}
+
+PrefilteredSearch::PrefilteredSearch(const string& regEx)
+    : PrefilteredSearch(thompson(regEx).flat, extractLiterals(regEx)) {}
+
+bool PrefilteredSearch::search(string_view input, MatchSpan* span) {
+    counters.searches++;
+    size_t begin = findLiteral(input, lits.prefix);
+    if (begin == string_view::npos || findLiteral(input, lits.required, begin) == string_view::npos) {
+        counters.rejected++;
+        return false;
+    }
+    counters.skippedBytes += begin;
+    if (!vm.search(input.substr(begin), span)) {
+        return false;
+    }
+    if (span) {
+        span->begin += begin;
+        span->end += begin;
+    }
+    return true;
+}
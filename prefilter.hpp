@@ -0,0 +1,59 @@
+#ifndef REGEX_NFA_PREFILTER_HPP
+#define REGEX_NFA_PREFILTER_HPP
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include "nfa.hpp"
+#include "pikevm.hpp"
+
+// Literales que toda cadena del lenguaje debe contener: prefix es un prefijo
+// comun a todas y required la subcadena obligatoria mas larga que se encontro
+// (puede ser el mismo prefijo). Vacios si no hay ninguno.
+struct Literals {
+    std::string prefix;
+    std::string required;
+};
+
+// Analiza la forma postfija de parseRegEx de abajo hacia arriba.
+Literals extractLiterals(const std::vector<char>& postfix);
+// Igual, a partir de la expresion original; lanza invalid_argument si es invalida.
+Literals extractLiterals(const std::string& regEx);
+
+// Primera aparicion de needle en hay a partir de from (npos si no hay): memchr
+// salta al siguiente candidato del primer byte y memcmp confirma el resto.
+size_t findLiteral(std::string_view hay, std::string_view needle, size_t from = 0);
+
+struct PrefilterStats {
+    uint64_t searches = 0;
+    uint64_t rejected = 0;      // descartadas sin ejecutar el automata
+    uint64_t skippedBytes = 0;  // bytes saltados antes del primer candidato
+};
+
+// Busqueda con prefiltro: si falta el literal obligatorio la entrada se
+// descarta sin simular el automata; si hay prefijo, la simulacion empieza en
+// su primera aparicion, ya que ninguna coincidencia puede empezar antes.
+// Mismo resultado que PikeVM::search. Usar una instancia por hilo.
+class PrefilteredSearch {
+public:
+    PrefilteredSearch(const FlatNFA& flat, Literals literals);
+    explicit PrefilteredSearch(const std::string& regEx);
+
+    bool search(std::string_view input, MatchSpan* span = nullptr);
+
+    const Literals& literals() const {
+        return lits;
+    }
+
+    const PrefilterStats& stats() const {
+        return counters;
+    }
+
+private:
+    Literals lits;
+    PikeVM vm;
+    PrefilterStats counters;
+};
+
+#endif
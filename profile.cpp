@@ -0,0 +1,188 @@
+#include "profile.hpp"
+#include "jsonwriter.hpp"
+#include <cmath>
+#include <algorithm>
+#include <iomanip>
+
+using namespace std;
+
+// Los tiempos se exportan en microsegundos enteros.
+static uint64_t micros(double ms) {
+    return static_cast<uint64_t>(llround(ms * 1000));
+}
+
+void Profile::addPhase(const char* name, Clock::time_point t0, Clock::time_point t1, const CounterValues* delta) {
+    double ms = chrono::duration<double, milli>(t1 - t0).count();
+    lock_guard<mutex> guard(lock);
+    if (tracing) {
+        record(name, t0, t1, -1);
+    }
+    auto it = find_if(phases.begin(), phases.end(), [&](const Phase& phase) {
+        return phase.name == name;
+    });
+    if (it == phases.end()) {
+        it = phases.insert(it, {name, 0, CounterValues()});
+    }
+    it->ms += ms;
+    if (delta) {
+        it->counters += *delta;
+    }
+}
+
+void Profile::addSpan(const char* name, Clock::time_point t0, Clock::time_point t1, int64_t arg) {
+    if (!tracing) {
+        return;
+    }
+    lock_guard<mutex> guard(lock);
+    record(name, t0, t1, arg);
+}
+
+// Con lock tomado. Los hilos se numeran en el orden en que aparecen.
+void Profile::record(const char* name, Clock::time_point t0, Clock::time_point t1, int64_t arg) {
+    thread::id self = this_thread::get_id();
+    auto it = find(threads.begin(), threads.end(), self);
+    uint32_t index = static_cast<uint32_t>(it - threads.begin());
+    if (it == threads.end()) {
+        threads.push_back(self);
+    }
+    spans.push_back({name, index, arg, t0, t1});
+}
+
+void Profile::addAutomaton(const FlatNFA& flat, bool output) {
+    if (output) {
+        outputStates += flat.size();
+        outputTransitions += flat.targets.size();
+        return;
+    }
+    uint64_t eps = 0;
+    for (auto c : flat.labels) {
+        eps += c == '$';
+    }
+    states += flat.size();
+    transitions += flat.targets.size();
+    epsilonTransitions += eps;
+}
+
+void Profile::writeJson(OutputSink& sink) const {
+    JsonWriter w(sink, 0);
+    w.beginObject();
+    w.key("wall_us");
+    w.value(micros(wallMs));
+    w.key("phases_us");
+    w.beginObject();
+    {
+        lock_guard<mutex> guard(lock);
+        for (auto& phase : phases) {
+            w.key(phase.name);
+            w.value(micros(phase.ms));
+        }
+    }
+    w.endObject();
+    w.key("entries");
+    w.value(entries.load());
+    w.key("states");
+    w.value(states.load());
+    w.key("transitions");
+    w.value(transitions.load());
+    w.key("epsilon_transitions");
+    w.value(epsilonTransitions.load());
+    w.key("output_states");
+    w.value(outputStates.load());
+    w.key("output_transitions");
+    w.value(outputTransitions.load());
+    w.key("allocations");
+    w.value(allocations);
+    w.key("bytes_allocated");
+    w.value(bytesAllocated);
+    w.key("bytes_written");
+    w.value(bytesWritten.load());
+    w.endObject();
+    sink.put('\n');
+}
+
+void Profile::writeTrace(OutputSink& sink) const {
+    lock_guard<mutex> guard(lock);
+    auto us = [&](Clock::time_point t) {
+        return chrono::duration<double, micro>(t - origin).count();
+    };
+    // Un evento por linea: el archivo queda legible y se puede filtrar con grep.
+    JsonWriter w(sink, 0);
+    w.beginObject();
+    w.key("displayTimeUnit");
+    w.value("ms");
+    w.key("traceEvents");
+    w.beginArray();
+    for (size_t t = 0; t < threads.size(); ++t) {
+        sink.put('\n');
+        w.beginObject();
+        w.key("name");
+        w.value("thread_name");
+        w.key("ph");
+        w.value("M");
+        w.key("pid");
+        w.value(1);
+        w.key("tid");
+        w.value(static_cast<uint64_t>(t));
+        w.key("args");
+        w.beginObject();
+        w.key("name");
+        w.value(t == 0 ? string("main") : "worker " + to_string(t));
+        w.endObject();
+        w.endObject();
+    }
+    for (const Span& span : spans) {
+        sink.put('\n');
+        w.beginObject();
+        w.key("name");
+        w.value(span.name);
+        w.key("ph");
+        w.value("X");
+        w.key("pid");
+        w.value(1);
+        w.key("tid");
+        w.value(span.thread);
+        w.key("ts");
+        w.value(us(span.t0), 3);
+        w.key("dur");
+        w.value(us(span.t1) - us(span.t0), 3);
+        if (span.arg >= 0) {
+            w.key("args");
+            w.beginObject();
+            w.key("index");
+            w.value(span.arg);
+            w.endObject();
+        }
+        w.endObject();
+    }
+    w.endArray();
+    w.endObject();
+    sink.put('\n');
+}
+
+void Profile::writeCounters(ostream& out, const PerfCounters& available) const {
+    lock_guard<mutex> guard(lock);
+    out << left << setw(16) << "phase" << right << setw(12) << "ms";
+    for (int c = 0; c < PERF_COUNTERS; ++c) {
+        out << setw(16) << PerfCounters::name(static_cast<PerfCounter>(c));
+    }
+    out << setw(8) << "IPC" << endl;
+    for (auto& phase : phases) {
+        out << left << setw(16) << phase.name << right << fixed << setprecision(3) << setw(12) << phase.ms;
+        for (int c = 0; c < PERF_COUNTERS; ++c) {
+            out << setw(16);
+            if (available.available(static_cast<PerfCounter>(c))) {
+                out << phase.counters.value[c];
+            } else {
+                out << "-";
+            }
+        }
+        uint64_t cycles = phase.counters.value[PERF_CYCLES];
+        out << setw(8);
+        if (cycles > 0 && available.available(PERF_INSTRUCTIONS)) {
+            out << setprecision(2) << static_cast<double>(phase.counters.value[PERF_INSTRUCTIONS]) / cycles;
+        } else {
+            out << "-";
+        }
+        out << endl;
+    }
+}
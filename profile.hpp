@@ -0,0 +1,156 @@
+#ifndef REGEX_NFA_PROFILE_HPP
+#define REGEX_NFA_PROFILE_HPP
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include "nfa.hpp"
+#include "perfcounters.hpp"
+
+// Mediciones de una corrida de la herramienta (--stats): tiempo acumulado por
+// fase, en el orden en que cada fase aparece por primera vez, y contadores de
+// los automatas construidos. Puede alimentarse desde varios hilos; en modo por
+// lotes los tiempos de fase suman lo que tardo cada hilo.
+//
+// Con tracing ademas guarda cada intervalo medido, con su hilo, para exportarlo
+// como traza de Chrome (--trace). Con counters, cada fase suma tambien los
+// contadores de hardware del hilo que la ejecuta (--counters).
+class Profile {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    std::atomic<uint64_t> entries{0};
+    std::atomic<uint64_t> states{0};
+    std::atomic<uint64_t> transitions{0};
+    std::atomic<uint64_t> epsilonTransitions{0};
+    std::atomic<uint64_t> outputStates{0};
+    std::atomic<uint64_t> outputTransitions{0};
+    std::atomic<uint64_t> bytesWritten{0};
+    // Los completa el ejecutable, que es quien puede contar las reservas.
+    uint64_t allocations = 0;
+    uint64_t bytesAllocated = 0;
+    double wallMs = 0;
+
+    explicit Profile(bool tracing = false, bool counters = false)
+        : tracing(tracing), counters(counters), origin(Clock::now()) {}
+
+    // Suma el intervalo (y, si se pasan, los contadores) a la fase y, con
+    // tracing, lo guarda como span.
+    void addPhase(const char* name, Clock::time_point t0, Clock::time_point t1,
+                  const CounterValues* delta = nullptr);
+    // Solo traza: un span que no cuenta como fase. arg, si no es negativo, se
+    // exporta como "index" (por ejemplo, la entrada de un lote).
+    void addSpan(const char* name, Clock::time_point t0, Clock::time_point t1, int64_t arg = -1);
+    bool isTracing() const {
+        return tracing;
+    }
+    bool isCounting() const {
+        return counters;
+    }
+    // Suma estados y aristas del automata de Thompson o, con output, del que
+    // se exporta.
+    void addAutomaton(const FlatNFA& flat, bool output);
+    // Un objeto JSON en una linea.
+    void writeJson(OutputSink& sink) const;
+    // Formato trace-event de Chrome/Perfetto: un evento completo ("X") por
+    // span, con tiempos en microsegundos desde la creacion del perfil. El hilo
+    // que registra el primer span es "main"; los demas, "worker N".
+    void writeTrace(OutputSink& sink) const;
+    // Tabla de contadores por fase, con la disponibilidad de available.
+    void writeCounters(std::ostream& out, const PerfCounters& available) const;
+
+private:
+    struct Phase {
+        std::string name;
+        double ms;
+        CounterValues counters;
+    };
+    struct Span {
+        const char* name;
+        uint32_t thread;
+        int64_t arg;
+        Clock::time_point t0, t1;
+    };
+
+    bool tracing;
+    bool counters;
+    Clock::time_point origin;
+    mutable std::mutex lock;
+    std::vector<Phase> phases;
+    std::vector<Span> spans;
+    std::vector<std::thread::id> threads;
+
+    void record(const char* name, Clock::time_point t0, Clock::time_point t1, int64_t arg);
+};
+
+// Mide el tiempo entre su construccion y stop() (o su destruccion) y lo suma
+// a la fase indicada. Con profile nulo no hace nada.
+class PhaseScope {
+public:
+    PhaseScope(Profile* profile, const char* name) : profile(profile), name(name) {
+        if (profile && profile->isCounting()) {
+            c0 = PerfCounters::forThread().read();
+        }
+        if (profile) {
+            t0 = Profile::Clock::now();
+        }
+    }
+    PhaseScope(const PhaseScope&) = delete;
+    PhaseScope& operator=(const PhaseScope&) = delete;
+
+    ~PhaseScope() {
+        stop();
+    }
+
+    void stop() {
+        if (profile) {
+            Profile::Clock::time_point t1 = Profile::Clock::now();
+            if (profile->isCounting()) {
+                CounterValues delta = PerfCounters::forThread().read() - c0;
+                profile->addPhase(name, t0, t1, &delta);
+            } else {
+                profile->addPhase(name, t0, t1);
+            }
+            profile = nullptr;
+        }
+    }
+
+private:
+    Profile* profile;
+    const char* name;
+    Profile::Clock::time_point t0;
+    CounterValues c0;
+};
+
+// Como PhaseScope, pero solo aparece en la traza: sirve para agrupar fases
+// (una etapa de main, una entrada del lote) sin contarlas dos veces.
+class TraceScope {
+public:
+    TraceScope(Profile* profile, const char* name, int64_t arg = -1)
+        : profile(profile && profile->isTracing() ? profile : nullptr), name(name), arg(arg) {
+        if (this->profile) {
+            t0 = Profile::Clock::now();
+        }
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    ~TraceScope() {
+        if (profile) {
+            profile->addSpan(name, t0, Profile::Clock::now(), arg);
+        }
+    }
+
+private:
+    Profile* profile;
+    const char* name;
+    int64_t arg;
+    Profile::Clock::time_point t0;
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include "regexgen.hpp"
+#include "nfa.hpp"
+#include <stdexcept>
+
+using namespace std;
+
+RegexGenerator::RegexGenerator(const GeneratorOptions& opts) : opts(opts), state(opts.seed) {
+    for (char c : opts.symbols) {
+        if (ALPHABET.find(c) == string::npos || OPERATORS.count(c) || c == '$') {
+            throw invalid_argument(string("Generator symbol is not a literal: ") + c);
+        }
+    }
+    if (opts.symbols.empty() && opts.epsilonRate < 1) {
+        throw invalid_argument("Generator needs at least one symbol");
+    }
+    if (opts.concatWeight < 0 || opts.unionWeight < 0 || opts.starWeight < 0 ||
+        opts.concatWeight + opts.unionWeight <= 0) {
+        throw invalid_argument("Generator needs a positive concat or union weight");
+    }
+}
+
+// splitmix64: rapido, sin estado oculto y con la misma salida en todas partes.
+uint64_t RegexGenerator::random() {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+size_t RegexGenerator::below(size_t n) {
+    return static_cast<size_t>(random() % n);
+}
+
+double RegexGenerator::unit() {
+    return static_cast<double>(random() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+void RegexGenerator::leaf(string& out) {
+    if (opts.epsilonRate > 0 && unit() < opts.epsilonRate) {
+        out.push_back('$');
+    } else {
+        out.push_back(opts.symbols[below(opts.symbols.size())]);
+    }
+}
+
+// Une leaves hojas con un mismo operador, sin anidar.
+void RegexGenerator::flat(string& out, size_t leaves, bool unionOp) {
+    if (unionOp) {
+        out.push_back('(');
+    }
+    for (size_t i = 0; i < leaves; ++i) {
+        if (i > 0 && (unionOp || opts.explicitConcat)) {
+            out.push_back(unionOp ? '+' : '.');
+        }
+        leaf(out);
+    }
+    if (unionOp) {
+        out.push_back(')');
+    }
+}
+
+void RegexGenerator::node(string& out, size_t leaves, size_t depth, size_t stars) {
+    double star = stars < opts.maxStarNesting ? opts.starWeight : 0;
+    double total = opts.concatWeight + opts.unionWeight + star;
+    double pick = unit() * total;
+    if (leaves == 1) {
+        leaf(out);
+        if (pick < star) {
+            out.push_back('*');
+        }
+        return;
+    }
+    bool unionOp = pick >= star && pick < star + opts.unionWeight;
+    if (depth >= opts.maxDepth) {
+        flat(out, leaves, unionOp);
+        return;
+    }
+    if (pick < star) {
+        out.push_back('(');
+        node(out, leaves, depth + 1, stars + 1);
+        out += ")*";
+        return;
+    }
+
+    // Aridad minima para repartir las hojas en la profundidad que queda, y
+    // luego una al azar entre 2 y el doble de esa.
+    size_t remaining = opts.maxDepth - depth;
+    size_t fan = 2;
+    for (;;) {
+        size_t reach = 1;
+        for (size_t i = 0; i < remaining && reach < leaves; ++i) {
+            reach *= fan;
+        }
+        if (reach >= leaves) {
+            break;
+        }
+        fan++;
+    }
+    size_t k = min(leaves, 2 + below(2 * fan - 1));
+
+    if (unionOp) {
+        out.push_back('(');
+    }
+    size_t left = leaves - k;
+    for (size_t i = 0; i < k; ++i) {
+        size_t extra = left;
+        if (i + 1 < k) {
+            extra = min(left, below(2 * left / (k - i) + 1));
+        }
+        left -= extra;
+        if (i > 0 && (unionOp || opts.explicitConcat)) {
+            out.push_back(unionOp ? '+' : '.');
+        }
+        node(out, 1 + extra, depth + 1, stars);
+    }
+    if (unionOp) {
+        out.push_back(')');
+    }
+}
+
+void RegexGenerator::next(string& out) {
+    if (opts.length > 0) {
+        node(out, opts.length, 0, 0);
+    }
+}
+
+string RegexGenerator::next() {
+    string out;
+    out.reserve(opts.length * 2);
+    next(out);
+    return out;
+}
+
+string generateRegex(const GeneratorOptions& opts) {
+    return RegexGenerator(opts).next();
+}
@@ -0,0 +1,55 @@
+#ifndef REGEX_NFA_REGEXGEN_HPP
+#define REGEX_NFA_REGEXGEN_HPP
+
+#include <string>
+#include <cstdint>
+
+// Parametros del generador de expresiones sinteticas. length es la cantidad
+// de simbolos del alfabeto (hojas) de cada expresion; maxDepth limita el
+// anidamiento de parentesis, asi que las expresiones largas se arman con
+// concatenaciones y uniones de muchos operandos en vez de arboles profundos.
+struct GeneratorOptions {
+    uint64_t seed = 1;
+    size_t length = 32;
+    size_t maxDepth = 6;
+    size_t maxStarNesting = 2;
+    // Peso relativo de cada operador al elegir el nodo siguiente.
+    double concatWeight = 3;
+    double unionWeight = 2;
+    double starWeight = 1;
+    // Probabilidad de que una hoja sea '$' en lugar de un simbolo.
+    double epsilonRate = 0;
+    // Escribe '.' entre operandos concatenados en lugar de yuxtaponerlos.
+    bool explicitConcat = false;
+    // Simbolos posibles en las hojas; deben pertenecer a ALPHABET.
+    std::string symbols = "abcdefghijklmnopqrstuvwxyz0123456789";
+};
+
+// Genera expresiones validas para parseRegEx. Con la misma semilla y las mismas
+// opciones produce siempre la misma secuencia, en cualquier plataforma: usa su
+// propio generador (splitmix64) en lugar de las distribuciones de <random>.
+class RegexGenerator {
+public:
+    // Lanza invalid_argument si las opciones no permiten generar nada.
+    explicit RegexGenerator(const GeneratorOptions& opts);
+
+    std::string next();
+    // Agrega la expresion al final de out, sin copias intermedias.
+    void next(std::string& out);
+
+private:
+    GeneratorOptions opts;
+    uint64_t state;
+
+    uint64_t random();
+    size_t below(size_t n);
+    double unit();
+    void leaf(std::string& out);
+    void flat(std::string& out, size_t leaves, bool unionOp);
+    void node(std::string& out, size_t leaves, size_t depth, size_t stars);
+};
+
+// Atajo para una sola expresion.
+std::string generateRegex(const GeneratorOptions& opts);
+
+#endif
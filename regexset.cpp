@@ -0,0 +1,181 @@
+#include "regexset.hpp"
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+RegexSet::RegexSet(const vector<string>& patterns) : patterns(patterns.size()) {
+    // Cada patron se construye en la misma arena y se copia su tabla plana
+    // desplazada detras del estado 0, que es el inicio comun.
+    auto arena = make_shared<StateArena>();
+    vector<FlatNFA> parts;
+    parts.reserve(patterns.size());
+    for (size_t k = 0; k < patterns.size(); ++k) {
+        arena->reset();
+        try {
+            parts.push_back(thompson(patterns[k], arena).flat);
+        } catch (const invalid_argument&) {
+            throw invalid_argument("Invalid regular expression at index " + to_string(k));
+        }
+    }
+
+    table.offsets.push_back(0);
+    owner.push_back(NO_PATTERN);
+    uint32_t base = 1;
+    for (auto& part : parts) {
+        table.targets.push_back(base + part.start);
+        table.labels.push_back('$');
+        base += static_cast<uint32_t>(part.size());
+    }
+    table.offsets.push_back(static_cast<uint32_t>(table.targets.size()));
+    base = 1;
+    for (uint32_t k = 0; k < parts.size(); ++k) {
+        const FlatNFA& part = parts[k];
+        for (uint32_t s = 0; s < part.size(); ++s) {
+            for (uint32_t e = part.offsets[s]; e < part.offsets[s + 1]; ++e) {
+                table.targets.push_back(base + part.targets[e]);
+                table.labels.push_back(part.labels[e]);
+            }
+            table.offsets.push_back(static_cast<uint32_t>(table.targets.size()));
+            owner.push_back(k);
+        }
+        for (auto s : part.accept) {
+            table.accept.push_back(base + s);
+        }
+        base += static_cast<uint32_t>(part.size());
+    }
+    table.start = 0;
+
+    isAccept.assign(table.size(), 0);
+    for (auto s : table.accept) {
+        isAccept[s] = 1;
+    }
+    epsilonClosureLists(table, closureOffsets, closureStates);
+    // Para cada byte, los estados a los que se llega desde la clausura del
+    // inicio: la busqueda los inyecta directamente en vez de recorrer en cada
+    // posicion la clausura completa, que crece con el numero de patrones.
+    vector<vector<uint32_t>> byByte(256);
+    for (uint32_t i = closureOffsets[table.start]; i < closureOffsets[table.start + 1]; ++i) {
+        uint32_t s = closureStates[i];
+        for (uint32_t e = table.offsets[s]; e < table.offsets[s + 1]; ++e) {
+            unsigned char c = table.labels[e];
+            if (c == '$') {
+                continue;
+            }
+            uint32_t t = table.targets[e];
+            byByte[c].insert(byByte[c].end(), closureStates.begin() + closureOffsets[t],
+                             closureStates.begin() + closureOffsets[t + 1]);
+        }
+    }
+    startOffsets.push_back(0);
+    for (auto& list : byByte) {
+        sort(list.begin(), list.end());
+        list.erase(unique(list.begin(), list.end()), list.end());
+        startStates.insert(startStates.end(), list.begin(), list.end());
+        startOffsets.push_back(static_cast<uint32_t>(startStates.size()));
+    }
+    clist = SparseSet(table.size());
+    nlist = SparseSet(table.size());
+    matched.assign(patterns.size(), 0);
+}
+
+void RegexSet::addClosure(SparseSet& set, uint32_t s) const {
+    for (uint32_t i = closureOffsets[s]; i < closureOffsets[s + 1]; ++i) {
+        uint32_t t = closureStates[i];
+        if (!set.contains(t)) {
+            set.insert(t);
+        }
+    }
+}
+
+// Avanza los hilos de clist con el simbolo c; descarta los de patrones que
+// ya coincidieron. El estado 0 solo tiene aristas '$', asi que nunca aparece
+// en las clausuras y owner[s] siempre es un patron valido.
+void RegexSet::step(unsigned char c, bool restart) {
+    nlist.clear();
+    for (size_t k = 0; k < clist.size(); ++k) {
+        uint32_t s = clist[k];
+        if (matched[owner[s]]) {
+            continue;
+        }
+        for (uint32_t e = table.offsets[s]; e < table.offsets[s + 1]; ++e) {
+            if (table.labels[e] == c && c != '$') {
+                addClosure(nlist, table.targets[e]);
+            }
+        }
+    }
+    if (restart) {
+        for (uint32_t i = startOffsets[c]; i < startOffsets[c + 1]; ++i) {
+            uint32_t t = startStates[i];
+            if (!matched[owner[t]] && !nlist.contains(t)) {
+                nlist.insert(t);
+            }
+        }
+    }
+    swap(clist, nlist);
+}
+
+// Marca los patrones con algun estado de aceptacion en clist y devuelve los
+// ids nuevos ordenados; deja matched en cero.
+vector<uint32_t> RegexSet::collect() {
+    vector<uint32_t> ids;
+    for (size_t k = 0; k < clist.size(); ++k) {
+        uint32_t s = clist[k];
+        if (isAccept[s] && !matched[owner[s]]) {
+            matched[owner[s]] = 1;
+            ids.push_back(owner[s]);
+        }
+    }
+    for (auto id : ids) {
+        matched[id] = 0;
+    }
+    sort(ids.begin(), ids.end());
+    return ids;
+}
+
+vector<uint32_t> RegexSet::matches(string_view input) {
+    if (patterns == 0) {
+        return {};
+    }
+    clist.clear();
+    addClosure(clist, table.start);
+    for (char ch : input) {
+        step(static_cast<unsigned char>(ch), false);
+        if (clist.size() == 0) {
+            return {};
+        }
+    }
+    return collect();
+}
+
+vector<uint32_t> RegexSet::search(string_view input) {
+    if (patterns == 0) {
+        return {};
+    }
+    // En cada posicion se vuelve a entrar por el inicio (via startStates); un
+    // patron se deja de simular en cuanto coincide, y la busqueda termina
+    // cuando coinciden todos.
+    vector<uint32_t> ids;
+    clist.clear();
+    addClosure(clist, table.start);
+    for (size_t i = 0;; ++i) {
+        for (size_t k = 0; k < clist.size(); ++k) {
+            uint32_t s = clist[k];
+            if (isAccept[s] && !matched[owner[s]]) {
+                matched[owner[s]] = 1;
+                ids.push_back(owner[s]);
+            }
+        }
+        if (i == input.size() || ids.size() == patterns) {
+            break;
+        }
+        step(static_cast<unsigned char>(input[i]), true);
+    }
+    for (auto id : ids) {
+        matched[id] = 0;
+    }
+    sort(ids.begin(), ids.end());
+    return ids;
+}
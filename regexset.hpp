@@ -0,0 +1,58 @@
+#ifndef REGEX_NFA_REGEXSET_HPP
+#define REGEX_NFA_REGEXSET_HPP
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include "nfa.hpp"
+#include "pikevm.hpp"
+
+// Varias expresiones combinadas en un solo automata: un estado inicial comun
+// con aristas '$' hacia el inicio de cada una (como kleene_union, pero con n
+// ramas), y cada estado etiquetado con el patron al que pertenece. Una sola
+// pasada sobre la entrada informa todos los patrones que coinciden.
+// Guarda memoria de trabajo propia: usar una instancia por hilo.
+class RegexSet {
+public:
+    static constexpr uint32_t NO_PATTERN = UINT32_MAX;
+
+    // Lanza invalid_argument si alguna expresion es invalida.
+    explicit RegexSet(const std::vector<std::string>& patterns);
+
+    size_t size() const {
+        return patterns;
+    }
+
+    const FlatNFA& flat() const {
+        return table;
+    }
+
+    // Patron dueno del estado s (NO_PATTERN para el inicio comun).
+    uint32_t patternOf(uint32_t s) const {
+        return owner[s];
+    }
+
+    // Ids, en orden creciente, de los patrones que aceptan la entrada completa.
+    std::vector<uint32_t> matches(std::string_view input);
+    // Ids, en orden creciente, de los patrones que aceptan alguna subcadena.
+    std::vector<uint32_t> search(std::string_view input);
+
+private:
+    size_t patterns;
+    FlatNFA table;
+    std::vector<uint32_t> owner;
+    std::vector<char> isAccept;
+    std::vector<uint32_t> closureOffsets;
+    std::vector<uint32_t> closureStates;
+    std::vector<uint32_t> startOffsets;     // 257 entradas, indexadas por byte
+    std::vector<uint32_t> startStates;
+    SparseSet clist, nlist;
+    std::vector<char> matched;
+
+    void addClosure(SparseSet& set, uint32_t s) const;
+    void step(unsigned char c, bool restart);
+    std::vector<uint32_t> collect();
+};
+
+#endif
@@ -0,0 +1,75 @@
+#include "threadpool.hpp"
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <algorithm>
+
+using namespace std;
+
+WorkStealingPool::WorkStealingPool(size_t threads) : workers(max<size_t>(1, threads)) {}
+
+void WorkStealingPool::run(size_t count, const function<void(size_t, size_t)>& task) {
+    struct Queue {
+        mutex lock;
+        deque<size_t> items;
+    };
+    vector<Queue> queues(workers);
+    size_t chunk = (count + workers - 1) / workers;
+    for (size_t w = 0; w < workers; ++w) {
+        for (size_t i = w * chunk; i < min(count, (w + 1) * chunk); ++i) {
+            queues[w].items.push_back(i);
+        }
+    }
+
+    mutex errorLock;
+    exception_ptr error;
+    auto body = [&](size_t w) {
+        while (true) {
+            size_t item = 0;
+            bool found = false;
+            {
+                lock_guard<mutex> guard(queues[w].lock);
+                if (!queues[w].items.empty()) {
+                    item = queues[w].items.back();
+                    queues[w].items.pop_back();
+                    found = true;
+                }
+            }
+            for (size_t k = 1; k < workers && !found; ++k) {
+                Queue& victim = queues[(w + k) % workers];
+                lock_guard<mutex> guard(victim.lock);
+                if (!victim.items.empty()) {
+                    item = victim.items.front();
+                    victim.items.pop_front();
+                    found = true;
+                }
+            }
+            // No se agregan tareas nuevas: si no queda nada que robar, termino.
+            if (!found) {
+                return;
+            }
+            try {
+                task(item, w);
+            } catch (...) {
+                lock_guard<mutex> guard(errorLock);
+                if (!error) {
+                    error = current_exception();
+                }
+            }
+        }
+    };
+
+    vector<thread> threads;
+    for (size_t w = 1; w < workers; ++w) {
+        threads.emplace_back(body, w);
+    }
+    body(0);
+    for (auto& t : threads) {
+        t.join();
+    }
+    if (error) {
+        rethrow_exception(error);
+    }
+}
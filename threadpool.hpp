@@ -0,0 +1,27 @@
+#ifndef REGEX_NFA_THREADPOOL_HPP
+#define REGEX_NFA_THREADPOOL_HPP
+
+#include <cstddef>
+#include <functional>
+
+// Reparte las tareas 0..count-1 entre varios hilos. Cada hilo empieza con un
+// bloque contiguo en su propia cola y toma tareas del final; cuando la vacia,
+// roba del principio de las colas de los demas.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(size_t threads);
+
+    size_t size() const {
+        return workers;
+    }
+
+    // Ejecuta task(indice, hilo) para cada indice y espera a que terminen
+    // todas. hilo esta en [0, size()) y sirve para indexar estado por hilo.
+    // Si alguna tarea lanza una excepcion, la primera se relanza al final.
+    void run(size_t count, const std::function<void(size_t, size_t)>& task);
+
+private:
+    size_t workers;
+};
+
+#endif